@@ -0,0 +1,164 @@
+//
+// Created by oem on 10/06/23.
+//
+
+#ifndef DA___2ND_PROJECT_ARENA_H
+#define DA___2ND_PROJECT_ARENA_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief The Arena class allocates objects of one type in large contiguous chunks and frees them all at once.
+ *
+ * Objects never move once created, so pointers to them stay valid until clear() or the destruction of the arena.
+ *
+ * @tparam T The type of the objects stored in the arena.
+ */
+
+template <class T>
+class Arena {
+    /**
+     * @brief A block of raw storage for consecutive objects.
+     */
+
+    struct Chunk {
+        T *data; /**< The storage of the chunk */
+        size_t capacity; /**< Number of objects the chunk fits */
+        size_t used; /**< Number of objects created in the chunk */
+    };
+
+    static constexpr size_t MIN_CHUNK = 256; /**< Objects in the first chunk */
+
+    std::vector<Chunk> chunks; /**< The chunks, the last one is the one being filled */
+    size_t count = 0; /**< Number of live objects */
+
+    /**
+     * @brief Allocates a new chunk to fill.
+     *
+     * @param capacity The number of objects the chunk fits.
+     */
+
+    void grow(size_t capacity);
+
+public:
+
+    /**
+     * @brief Constructs an empty arena. No memory is allocated until the first object is created.
+     */
+
+    Arena() = default;
+
+    /**
+     * @brief Destroys every object of the arena and frees its chunks.
+     */
+
+    ~Arena();
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    /**
+     * @brief Constructs a new object in the arena.
+     *
+     * @param args The arguments forwarded to the constructor of T.
+     * @return A pointer to the object, owned by the arena.
+     */
+
+    template <class... Args>
+    T *create(Args &&... args);
+
+    /**
+     * @brief Makes sure the next n objects are created in a single chunk.
+     *
+     * @param n The number of objects about to be created.
+     */
+
+    void reserve(size_t n);
+
+    /**
+     * @brief Destroys every object of the arena and frees its chunks in one pass.
+     */
+
+    void clear();
+
+    /**
+     * @brief Returns the number of objects in the arena.
+     *
+     * @return The number of objects created since the last clear().
+     */
+
+    size_t size() const;
+
+    /**
+     * @brief Returns the storage held by the arena.
+     *
+     * @return The number of bytes allocated for chunks, used or not.
+     */
+
+    size_t memoryUsage() const;
+};
+
+template <class T>
+Arena<T>::~Arena() {
+    clear();
+}
+
+template <class T>
+void Arena<T>::grow(size_t capacity) {
+    T *data = static_cast<T *>(::operator new(capacity * sizeof(T)));
+    chunks.push_back({data, capacity, 0});
+}
+
+template <class T>
+template <class... Args>
+T *Arena<T>::create(Args &&... args) {
+    if (chunks.empty() || chunks.back().used == chunks.back().capacity) {
+        grow(chunks.empty() ? MIN_CHUNK : chunks.back().capacity * 2);
+    }
+    Chunk &chunk = chunks.back();
+    T *object = new (chunk.data + chunk.used) T(std::forward<Args>(args)...);
+    chunk.used++;
+    count++;
+    return object;
+}
+
+template <class T>
+void Arena<T>::reserve(size_t n) {
+    if (!chunks.empty() && chunks.back().capacity - chunks.back().used >= n) {
+        return;
+    }
+    size_t capacity = chunks.empty() ? MIN_CHUNK : chunks.back().capacity * 2;
+    grow(capacity < n ? n : capacity);
+}
+
+template <class T>
+void Arena<T>::clear() {
+    for (Chunk &chunk : chunks) {
+        for (size_t i = 0; i < chunk.used; i++) {
+            chunk.data[i].~T();
+        }
+        ::operator delete(chunk.data);
+    }
+    chunks.clear();
+    chunks.shrink_to_fit();
+    count = 0;
+}
+
+template <class T>
+size_t Arena<T>::size() const {
+    return count;
+}
+
+template <class T>
+size_t Arena<T>::memoryUsage() const {
+    size_t bytes = 0;
+    for (const Chunk &chunk : chunks) {
+        bytes += chunk.capacity * sizeof(T);
+    }
+    return bytes;
+}
+
+#endif //DA___2ND_PROJECT_ARENA_H
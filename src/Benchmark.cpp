@@ -0,0 +1,257 @@
+//
+// Created by oem on 10/06/23.
+//
+
+#include "Benchmark.h"
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include "ParallelBacktracking.h"
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#ifdef __linux__
+/**
+ * @brief Opens a hardware counter of the calling thread, stopped.
+ *
+ * @param config The PERF_COUNT_HW_* event to count.
+ * @return The file descriptor of the counter, or -1 if it is not available.
+ */
+
+static int openCounter(uint64_t config) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+/**
+ * @brief Returns the resident set size of the process.
+ *
+ * @return The number of resident bytes, read from /proc/self/statm, or 0 where that file does not exist.
+ */
+
+size_t Benchmark::residentBytes() {
+    ifstream statm("/proc/self/statm");
+    size_t pages = 0;
+    size_t resident = 0;
+    if (!(statm >> pages >> resident)) {
+        return 0;
+    }
+    return resident * (size_t) sysconf(_SC_PAGESIZE);
+}
+
+/**
+ * @brief Hands the memory freed by the process back to the operating system, where the allocator supports it.
+ *
+ * glibc keeps small freed blocks in its heap for reuse, so without a trim the resident set size would not show
+ * whether the graph was freed.
+ */
+
+void Benchmark::releaseFreeMemory() {
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+}
+
+/**
+ * @brief Adds up the bytes held by each structure of a graph.
+ *
+ * @param graph The graph.
+ * @return The bytes per structure; structures that were not built count 0.
+ */
+
+StructureMemory Benchmark::structureMemory(const Graph &graph) {
+    StructureMemory memory{};
+    memory.vertices = graph.vertexMemory();
+    memory.adjacency = graph.getAdjacency().memoryUsage();
+    memory.edgeIndex = graph.getEdgeIndex().memoryUsage();
+    memory.candidates = graph.getCandidates().memoryUsage();
+    memory.matrix = graph.getDistMatrix() == nullptr ? 0 : graph.getDistMatrix()->memoryUsage();
+    memory.nextHops = graph.getNextHops() == nullptr ? 0 : graph.getNextHops()->memoryUsage();
+    return memory;
+}
+
+/**
+ * @brief Repeatedly loads a graph and destroys it, sampling the resident set size after each step.
+ *
+ * A graph that frees everything it allocated returns to the baseline after every round instead of growing. The
+ * candidate lists are built after the timed load, so the loaded sample covers every structure the solvers use.
+ *
+ * @param load Fills an empty graph.
+ * @param rounds The number of load/unload rounds.
+ * @param baseline Receives the resident bytes measured before the first round.
+ * @return One sample per round.
+ */
+
+vector<MemorySample> Benchmark::loadUnload(const function<void(Graph &)> &load, int rounds, size_t &baseline) {
+    vector<MemorySample> samples;
+    releaseFreeMemory();
+    baseline = residentBytes();
+    for (int round = 0; round < rounds; round++) {
+        MemorySample sample{};
+        {
+            Graph graph;
+            auto startTime = chrono::high_resolution_clock::now();
+            load(graph);
+            chrono::duration<double> duration = chrono::high_resolution_clock::now() - startTime;
+            sample.seconds = duration.count();
+            // The candidate lists are built on first use; TAH uses them, so they count as part of a loaded graph
+            graph.getCandidates();
+            sample.loaded = residentBytes();
+            sample.structures = structureMemory(graph);
+        }
+        releaseFreeMemory();
+        sample.unloaded = residentBytes();
+        samples.push_back(sample);
+    }
+    return samples;
+}
+
+/**
+ * @brief Runs a piece of work while counting the last-level cache references and misses of the calling thread.
+ *
+ * The counters come from perf_event_open, so they are only available on Linux, and only where the kernel and the
+ * hardware expose them; elsewhere the work is only timed. Threads started by the work are not counted.
+ *
+ * @param work The work to measure.
+ * @return The measurements.
+ */
+
+CacheSample Benchmark::countCacheMisses(const function<void()> &work) {
+    CacheSample sample{};
+#ifdef __linux__
+    int references = openCounter(PERF_COUNT_HW_CACHE_REFERENCES);
+    int misses = references == -1 ? -1 : openCounter(PERF_COUNT_HW_CACHE_MISSES);
+    sample.counted = references != -1 && misses != -1;
+    if (sample.counted) {
+        ioctl(references, PERF_EVENT_IOC_RESET, 0);
+        ioctl(misses, PERF_EVENT_IOC_RESET, 0);
+        ioctl(references, PERF_EVENT_IOC_ENABLE, 0);
+        ioctl(misses, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+    auto startTime = chrono::high_resolution_clock::now();
+    work();
+    chrono::duration<double> duration = chrono::high_resolution_clock::now() - startTime;
+    sample.seconds = duration.count();
+#ifdef __linux__
+    if (sample.counted) {
+        ioctl(references, PERF_EVENT_IOC_DISABLE, 0);
+        ioctl(misses, PERF_EVENT_IOC_DISABLE, 0);
+        sample.counted = read(references, &sample.references, sizeof(long long)) == sizeof(long long)
+                         && read(misses, &sample.misses, sizeof(long long)) == sizeof(long long);
+        if (!sample.counted) {
+            sample.references = sample.misses = 0;
+        }
+    }
+    if (references != -1) close(references);
+    if (misses != -1) close(misses);
+#endif
+    return sample;
+}
+
+/**
+ * @brief The state of the baseline recursive backtracking search.
+ */
+
+struct RecursiveSearch {
+    const DistanceOracle &distances; /**< The distances between the vertices */
+    int n; /**< Number of vertices */
+    vector<int> path; /**< The path being searched */
+    vector<uint8_t> visited; /**< Whether each vertex is on the path */
+    double best; /**< The length of the shortest tour found */
+    size_t nodes; /**< Nodes visited */
+    chrono::high_resolution_clock::time_point start; /**< When the search started */
+    double timeLimit; /**< The most seconds to search */
+    bool stopped; /**< Whether the search ran out of time */
+
+/**
+ * @brief Searches the completions of the path.
+ *
+ * @param depth The number of vertices of the path.
+ * @param cost The length of the path.
+ */
+
+    void search(int depth, double cost) {
+        nodes++;
+        chrono::duration<double> elapsed = chrono::high_resolution_clock::now() - start;
+        if (elapsed.count() > timeLimit) {
+            stopped = true;
+            return;
+        }
+        if (depth == n) {
+            double d = distances(path[depth - 1], path[0]);
+            if (d != 0 && cost + d < best) {
+                best = cost + d;
+            }
+            return;
+        }
+        int last = path[depth - 1];
+        for (int i = 0; i < n && !stopped; i++) {
+            double d = distances(last, i);
+            if (d > 0 && cost + d < best && !visited[i]) {
+                visited[i] = true;
+                path[depth] = i;
+                search(depth + 1, cost + d);
+                visited[i] = false;
+            }
+        }
+    }
+};
+
+/**
+ * @brief Runs the recursive backtracking search BT() used before ParallelBacktracking, as a baseline.
+ *
+ * Every call reads the clock, every distance goes through the oracle and the visited vertices are kept in a byte
+ * vector, as they were.
+ *
+ * @param distances The distances between the vertices, 0 for missing edges.
+ * @param root The dense index of the vertex the tours start at.
+ * @param timeLimit The most seconds to search.
+ * @return The measurements.
+ */
+
+SearchSample Benchmark::recursiveBacktracking(const DistanceOracle &distances, int root, double timeLimit) {
+    int n = distances.getNumVertex();
+    RecursiveSearch search{distances, n, vector<int>(n), vector<uint8_t>(n), numeric_limits<double>::max(), 0,
+                           chrono::high_resolution_clock::now(), timeLimit, false};
+    search.path[0] = root;
+    search.visited[root] = true;
+    search.search(1, 0);
+    chrono::duration<double> duration = chrono::high_resolution_clock::now() - search.start;
+    return {duration.count(), search.nodes, !search.stopped};
+}
+
+/**
+ * @brief Runs the search kernel of ParallelBacktracking on one thread.
+ *
+ * @param distances The distances between the vertices, 0 for missing edges.
+ * @param root The dense index of the vertex the tours start at.
+ * @param timeLimit The most seconds to search.
+ * @return The measurements, the time to fill the dense matrix included.
+ */
+
+SearchSample Benchmark::backtrackingKernel(const DistanceOracle &distances, int root, double timeLimit) {
+    auto startTime = chrono::high_resolution_clock::now();
+    ParallelBacktracking search(distances, root, 1);
+    vector<int> path(distances.getNumVertex());
+    search.solve(path.data(), timeLimit);
+    chrono::duration<double> duration = chrono::high_resolution_clock::now() - startTime;
+    size_t nodes = search.getStats().empty() ? 0 : search.getStats().front().nodes;
+    return {duration.count(), nodes, search.isFinished()};
+}
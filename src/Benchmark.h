@@ -0,0 +1,150 @@
+//
+// Created by oem on 10/06/23.
+//
+
+#ifndef DA___2ND_PROJECT_BENCHMARK_H
+#define DA___2ND_PROJECT_BENCHMARK_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include "Graph.h"
+#include "DistanceOracle.h"
+
+using namespace std;
+
+/**
+ * @brief The StructureMemory struct holds the bytes held by each structure of a loaded graph.
+ */
+
+struct StructureMemory {
+    size_t vertices; /**< The vertex arena */
+    size_t adjacency; /**< The compact adjacency */
+    size_t edgeIndex; /**< The hash index of the edge weights */
+    size_t candidates; /**< The candidate neighbour lists, which TAH builds on first use */
+    size_t matrix; /**< The distance matrix */
+    size_t nextHops; /**< The next hops of the metric closure */
+};
+
+/**
+ * @brief The MemorySample struct holds the resident set size measured around one round of a benchmark.
+ */
+
+struct MemorySample {
+    size_t loaded; /**< Resident bytes while the graph is loaded */
+    size_t unloaded; /**< Resident bytes after the graph was destroyed */
+    double seconds; /**< Wall time of the load */
+    StructureMemory structures; /**< The bytes held by each structure of the loaded graph */
+};
+
+/**
+ * @brief The CacheSample struct holds the time and cache behaviour of one measured piece of work.
+ */
+
+struct CacheSample {
+    double seconds; /**< Wall time of the work */
+    bool counted; /**< Whether the hardware counters could be read; the counts are 0 otherwise */
+    long long references; /**< Last-level cache references */
+    long long misses; /**< Last-level cache misses */
+};
+
+/**
+ * @brief The SearchSample struct holds the throughput of one run of a search.
+ */
+
+struct SearchSample {
+    double seconds; /**< Wall time of the search */
+    size_t nodes; /**< Nodes of the search tree visited */
+    bool finished; /**< Whether the search ended before its time limit */
+};
+
+/**
+ * @brief The Benchmark class measures the time and memory behaviour of the loaders.
+ */
+
+class Benchmark {
+public:
+
+/**
+ * The most seconds each search of the backtracking benchmark runs.
+ */
+
+    static constexpr double SEARCH_SECONDS = 10;
+
+/**
+ * @brief Returns the resident set size of the process.
+ *
+ * @return The number of resident bytes, read from /proc/self/statm, or 0 where that file does not exist.
+ */
+
+    static size_t residentBytes();
+
+/**
+ * @brief Hands the memory freed by the process back to the operating system, where the allocator supports it.
+ */
+
+    static void releaseFreeMemory();
+
+/**
+ * @brief Adds up the bytes held by each structure of a graph.
+ *
+ * @param graph The graph.
+ * @return The bytes per structure; structures that were not built count 0.
+ */
+
+    static StructureMemory structureMemory(const Graph &graph);
+
+/**
+ * @brief Repeatedly loads a graph and destroys it, sampling the resident set size after each step.
+ *
+ * A graph that frees everything it allocated returns to the baseline after every round instead of growing. The
+ * candidate lists are built after the timed load, so the loaded sample covers every structure the solvers use.
+ *
+ * @param load Fills an empty graph.
+ * @param rounds The number of load/unload rounds.
+ * @param baseline Receives the resident bytes measured before the first round.
+ * @return One sample per round.
+ */
+
+    static vector<MemorySample> loadUnload(const function<void(Graph &)> &load, int rounds, size_t &baseline);
+
+/**
+ * @brief Runs a piece of work while counting the last-level cache references and misses of the calling thread.
+ *
+ * The counters come from perf_event_open, so they are only available on Linux, and only where the kernel and the
+ * hardware expose them; elsewhere the work is only timed. Threads started by the work are not counted.
+ *
+ * @param work The work to measure.
+ * @return The measurements.
+ */
+
+    static CacheSample countCacheMisses(const function<void()> &work);
+
+/**
+ * @brief Runs the recursive backtracking search BT() used before ParallelBacktracking, as a baseline.
+ *
+ * Every call reads the clock, every distance goes through the oracle and the visited vertices are kept in a byte
+ * vector, as they were.
+ *
+ * @param distances The distances between the vertices, 0 for missing edges.
+ * @param root The dense index of the vertex the tours start at.
+ * @param timeLimit The most seconds to search.
+ * @return The measurements.
+ */
+
+    static SearchSample recursiveBacktracking(const DistanceOracle &distances, int root, double timeLimit);
+
+/**
+ * @brief Runs the search kernel of ParallelBacktracking on one thread.
+ *
+ * @param distances The distances between the vertices, 0 for missing edges.
+ * @param root The dense index of the vertex the tours start at.
+ * @param timeLimit The most seconds to search.
+ * @return The measurements, the time to fill the dense matrix included.
+ */
+
+    static SearchSample backtrackingKernel(const DistanceOracle &distances, int root, double timeLimit);
+};
+
+
+#endif //DA___2ND_PROJECT_BENCHMARK_H
@@ -0,0 +1,419 @@
+//
+// Created by oem on 14/06/23.
+//
+
+#include "BranchAndBound.h"
+#include <algorithm>
+#include <limits>
+
+static const double UNREACHABLE = numeric_limits<double>::infinity();
+
+/**
+ * @brief Constructs a search over the vertices of an oracle.
+ *
+ * @param distances The distances between the vertices, 0 for missing edges. They must be symmetric.
+ * @param root The dense index of the vertex every tour starts and ends at.
+ */
+
+BranchAndBound::BranchAndBound(const DistanceOracle &distances, int root) :
+    n(distances.getNumVertex()),
+    root(root),
+    best(UNREACHABLE)
+{
+    if (n > MAX_VERTICES) {
+        return;
+    }
+    dist.assign((size_t) n * n, UNREACHABLE);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            double w = distances(i, j);
+            if (w > 0) {
+                dist[(size_t) i * n + j] = w;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Searches for the shortest tour.
+ *
+ * @param path Receives the shortest tour found, as dense indices starting at the root.
+ * @param initial A tour of n vertices to start from, or nullptr. It is only used as the first upper bound if it is
+ * valid.
+ * @param timeLimit The most seconds to search, or 0 for no limit.
+ * @return The length of the shortest tour found, or -1 if there is no tour or the graph has more than MAX_VERTICES
+ * vertices.
+ */
+
+double BranchAndBound::solve(int path[], const int *initial, double timeLimit) {
+    nodes = 0;
+    ticks = 0;
+    optimal = true;
+    best = UNREACHABLE;
+    bestPath.clear();
+    trees.clear();
+    shortest.clear();
+    if (n > MAX_VERTICES) {
+        return -1;
+    }
+    if (n == 1) {
+        path[0] = root;
+        return 0;
+    }
+    limited = timeLimit > 0;
+    deadline = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(timeLimit));
+    if (initial != nullptr) {
+        improve(vector<int>(initial, initial + n));
+    }
+
+    size_t capacity = MEMORY_CAP / 2 / (sizeof(Node) + n);
+    tableCapacity = MEMORY_CAP / 4 / TABLE_ENTRY_BYTES;
+    auto byBound = [](const Node &a, const Node &b) { return a.bound > b.bound; };
+    vector<Node> open;
+    uint64_t all = n == 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << n) - 1;
+    uint64_t start = (uint64_t) 1 << root;
+    open.push_back({remainder(root, all & ~start), 0, start, {(uint8_t) root}});
+
+    while (!open.empty()) {
+        if (expired()) {
+            optimal = false;
+            break;
+        }
+        pop_heap(open.begin(), open.end(), byBound);
+        Node node = std::move(open.back());
+        open.pop_back();
+        if (node.bound >= best) {
+            break;
+        }
+        int last = node.path.back();
+        for (int v : children(node.path, node.visited)) {
+            double cost = node.cost + d(last, v);
+            uint64_t visited = node.visited | (uint64_t) 1 << v;
+            vector<uint8_t> childPath = node.path;
+            childPath.push_back((uint8_t) v);
+            if ((int) childPath.size() == n) {
+                record(childPath, cost + d(v, root));
+                continue;
+            }
+            nodes++;
+            double bound = cost + remainder(v, all & ~visited);
+            if (bound >= best || dominated(visited, childPath[1], v, cost)) {
+                continue;
+            }
+            if (open.size() < capacity) {
+                open.push_back({bound, cost, visited, std::move(childPath)});
+                push_heap(open.begin(), open.end(), byBound);
+            }
+            else {
+                current = std::move(childPath);
+                depthFirst(cost, visited);
+            }
+        }
+    }
+
+    if (best == UNREACHABLE) {
+        return -1;
+    }
+    copy(bestPath.begin(), bestPath.end(), path);
+    return best;
+}
+
+/**
+ * @brief Checks if the last search proved its tour optimal.
+ *
+ * @return False if the search ran out of time, true otherwise.
+ */
+
+bool BranchAndBound::isOptimal() const {
+    return optimal;
+}
+
+/**
+ * @brief Returns the number of nodes the last search bounded.
+ *
+ * @return The number of nodes.
+ */
+
+size_t BranchAndBound::getNodes() const {
+    return nodes;
+}
+
+/**
+ * @brief Computes the lower bound of the tours that continue a path.
+ *
+ * The rest of such a tour leaves last for some unvisited vertex, visits every unvisited vertex along a path, which is
+ * a spanning tree of them, and returns to the root from one of them.
+ *
+ * @param last The vertex the path ends at.
+ * @param unvisited The vertices the path has not visited.
+ * @return The length the rest of any such tour has at least, infinity if there is none.
+ * @complexity O(|V|^2)
+ */
+
+double BranchAndBound::remainder(int last, uint64_t unvisited) {
+    if (unvisited == 0) {
+        return d(last, root);
+    }
+    int members[MAX_VERTICES];
+    int k = 0;
+    double enter = UNREACHABLE;
+    double leave = UNREACHABLE;
+    for (uint64_t rest = unvisited; rest != 0; rest &= rest - 1) {
+        int u = __builtin_ctzll(rest);
+        members[k++] = u;
+        enter = min(enter, d(last, u));
+        leave = min(leave, d(u, root));
+    }
+
+    double tree = spanningTree(unvisited);
+    if (tree == UNREACHABLE) {
+        return UNREACHABLE;
+    }
+
+    // Every unvisited vertex has two edges of the rest of the tour and the ends of the path one each, so half the sum
+    // of the cheapest edges of each is a bound too, often tighter when the distances are not metric
+    double ends = 0;
+    for (int i = 0; i < k; i++) {
+        int u = members[i];
+        double first = min(d(u, last), d(u, root));
+        double second = max(d(u, last), d(u, root));
+        for (int j = 0; j < k; j++) {
+            double w = d(u, members[j]);
+            if (j == i || w >= second) {
+                continue;
+            }
+            if (w < first) {
+                second = first;
+                first = w;
+            }
+            else {
+                second = w;
+            }
+        }
+        ends += first + second;
+    }
+    // With a single unvisited vertex both its edges go to the ends, last and root, which may be the same vertex
+    double degree = k == 1 ? enter + leave : (ends + enter + leave) / 2;
+    return max(enter + tree + leave, degree);
+}
+
+/**
+ * @brief Returns the weight of the minimum spanning tree of a set of vertices.
+ *
+ * Many paths leave the same vertices unvisited, so the weights are kept in a table while it fits in its share of
+ * MEMORY_CAP.
+ *
+ * @param vertices The vertices, as a mask.
+ * @return The weight of the tree, infinity if the vertices are not connected.
+ * @complexity O(|V|^2), O(1) when the set was seen before.
+ */
+
+double BranchAndBound::spanningTree(uint64_t vertices) {
+    auto cached = trees.find(vertices);
+    if (cached != trees.end()) {
+        return cached->second;
+    }
+    int members[MAX_VERTICES];
+    double key[MAX_VERTICES];
+    int k = 0;
+    for (uint64_t rest = vertices; rest != 0; rest &= rest - 1) {
+        members[k] = __builtin_ctzll(rest);
+        key[k++] = UNREACHABLE;
+    }
+
+    // Prim's algorithm; members[0..done) are in the tree
+    double tree = 0;
+    key[0] = 0;
+    for (int done = 0; done < k && tree != UNREACHABLE; done++) {
+        int next = done;
+        for (int i = done + 1; i < k; i++) {
+            if (key[i] < key[next]) {
+                next = i;
+            }
+        }
+        swap(members[done], members[next]);
+        swap(key[done], key[next]);
+        tree += key[done];
+        int u = members[done];
+        for (int i = done + 1; i < k; i++) {
+            key[i] = min(key[i], d(u, members[i]));
+        }
+    }
+    if (trees.size() < tableCapacity) {
+        trees.emplace(vertices, tree);
+    }
+    return tree;
+}
+
+/**
+ * @brief Checks if a path is beaten by another one that visits the same vertices, and records it otherwise.
+ *
+ * Two paths from the root with the same vertices, the same second vertex and the same last vertex have the same
+ * completions, so only the shorter one needs to be searched.
+ *
+ * @param visited The vertices of the path.
+ * @param second The second vertex of the path.
+ * @param last The last vertex of the path.
+ * @param cost The length of the path.
+ * @return True if a path at most as long with the same vertices and ends was already searched.
+ */
+
+bool BranchAndBound::dominated(uint64_t visited, int second, int last, double cost) {
+    State state{visited, (uint16_t) (second << 8 | last)};
+    auto seen = shortest.find(state);
+    if (seen != shortest.end()) {
+        if (seen->second <= cost) {
+            return true;
+        }
+        seen->second = cost;
+    }
+    else if (shortest.size() < tableCapacity) {
+        shortest.emplace(state, cost);
+    }
+    return false;
+}
+
+/**
+ * @brief Improves a tour with 2-opt moves until none shortens it, and keeps it if it is the best so far.
+ *
+ * @param tour The tour. It is ignored unless it visits every vertex once along existing edges.
+ */
+
+void BranchAndBound::improve(vector<int> tour) {
+    uint64_t seen = 0;
+    for (int v : tour) {
+        if (v < 0 || v >= n || (seen >> v & 1) != 0) {
+            return;
+        }
+        seen |= (uint64_t) 1 << v;
+    }
+    rotate(tour.begin(), find(tour.begin(), tour.end(), root), tour.end());
+    double cost = 0;
+    for (int i = 0; i < n; i++) {
+        cost += d(tour[i], tour[(i + 1) % n]);
+    }
+    if (cost == UNREACHABLE) {
+        return;
+    }
+    bool improved = true;
+    while (improved) {
+        improved = false;
+        for (int i = 1; i < n - 1; i++) {
+            for (int j = i + 1; j < n; j++) {
+                int a = tour[i - 1], b = tour[i], c = tour[j], e = tour[(j + 1) % n];
+                double delta = d(a, c) + d(b, e) - d(a, b) - d(c, e);
+                if (delta < -1e-9) {
+                    reverse(tour.begin() + i, tour.begin() + j + 1);
+                    improved = true;
+                }
+            }
+        }
+    }
+    cost = 0;
+    for (int i = 0; i < n; i++) {
+        cost += d(tour[i], tour[(i + 1) % n]);
+    }
+    if (cost < best) {
+        best = cost;
+        bestPath = tour;
+    }
+}
+
+/**
+ * @brief Records a tour that closes a path, if it is shorter than the best one.
+ *
+ * @param path The vertices of the path, all n of them.
+ * @param cost The length of the tour, including the edge back to the root.
+ */
+
+void BranchAndBound::record(const vector<uint8_t> &path, double cost) {
+    if (cost < best) {
+        best = cost;
+        bestPath.assign(path.begin(), path.end());
+    }
+}
+
+/**
+ * @brief Returns the vertices a path may continue to, nearest first.
+ *
+ * A tour and its reverse have the same length, so only the direction where the vertex after the root has a smaller
+ * index than the vertex before it is searched: every path must leave unvisited some vertex with a larger index than
+ * its second vertex, to close the tour with.
+ *
+ * @param path The vertices of the path.
+ * @param visited The vertices of the path, as a mask.
+ * @return The unvisited vertices adjacent to the end of the path, without those that would repeat a tour backwards.
+ */
+
+vector<int> BranchAndBound::children(const vector<uint8_t> &path, uint64_t visited) const {
+    int last = path.back();
+    uint64_t all = n == 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << n) - 1;
+    uint64_t unvisited = all & ~visited;
+    vector<int> result;
+    for (uint64_t rest = unvisited; rest != 0; rest &= rest - 1) {
+        int v = __builtin_ctzll(rest);
+        if (d(last, v) == UNREACHABLE) {
+            continue;
+        }
+        uint64_t remaining = unvisited & ~((uint64_t) 1 << v);
+        int second = path.size() >= 2 ? path[1] : v;
+        if (remaining == 0 ? path.size() >= 2 && v < second : 63 - __builtin_clzll(remaining) < second) {
+            continue;
+        }
+        result.push_back(v);
+    }
+    sort(result.begin(), result.end(), [this, last](int a, int b) {
+        return d(last, a) < d(last, b);
+    });
+    return result;
+}
+
+/**
+ * @brief Searches the subtree of a node depth-first.
+ *
+ * @param cost The length of the path in current.
+ * @param visited The vertices of the path in current.
+ */
+
+void BranchAndBound::depthFirst(double cost, uint64_t visited) {
+    if (expired()) {
+        optimal = false;
+        return;
+    }
+    int last = current.back();
+    uint64_t all = n == 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << n) - 1;
+    for (int v : children(current, visited)) {
+        double next = cost + d(last, v);
+        current.push_back((uint8_t) v);
+        if ((int) current.size() == n) {
+            record(current, next + d(v, root));
+        }
+        else {
+            nodes++;
+            uint64_t with = visited | (uint64_t) 1 << v;
+            if (next + remainder(v, all & ~with) < best && !dominated(with, current[1], v, next)) {
+                depthFirst(next, with);
+            }
+        }
+        current.pop_back();
+        if (!optimal) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Checks the deadline every few thousand nodes.
+ *
+ * @return True if the search must stop.
+ */
+
+bool BranchAndBound::expired() {
+    if (!limited || !optimal) {
+        return !optimal;
+    }
+    if ((++ticks & 4095) == 0 && chrono::steady_clock::now() > deadline) {
+        optimal = false;
+    }
+    return !optimal;
+}
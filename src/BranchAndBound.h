@@ -0,0 +1,228 @@
+//
+// Created by oem on 14/06/23.
+//
+
+#ifndef DA___2ND_PROJECT_BRANCHANDBOUND_H
+#define DA___2ND_PROJECT_BRANCHANDBOUND_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "DistanceOracle.h"
+
+using namespace std;
+
+/**
+ * @brief The BranchAndBound class finds the shortest tour exactly by a branch-and-bound search over partial tours.
+ *
+ * A node of the search is a path from the start. Its bound adds to the length of the path the minimum spanning tree
+ * of the unvisited vertices and the cheapest edges joining that tree to the end of the path and back to the start,
+ * since the rest of any tour through the node is a path of that shape. Nodes whose bound reaches the best tour found
+ * are pruned, starting from a nearest-neighbour tour improved by 2-opt.
+ *
+ * Every tour is found once instead of twice: the vertex that closes the tour must have a larger index than the one
+ * that follows the start. Children are tried nearest first. Open nodes are kept in a best-first queue while it fits in
+ * MEMORY_CAP; past it, nodes are searched depth-first, which only needs memory for one path.
+ */
+
+class BranchAndBound {
+public:
+
+/**
+ * The most vertices a graph may have; visited sets are 64-bit masks.
+ */
+
+    static constexpr int MAX_VERTICES = 64;
+
+/**
+ * The most memory the search may take. Half of it holds the queue of open nodes, past which the search turns
+ * depth-first, and a quarter each the tables of spanning trees and of the shortest paths to each state.
+ */
+
+    static constexpr size_t MEMORY_CAP = (size_t) 256 << 20;
+
+/**
+ * @brief Constructs a search over the vertices of an oracle.
+ *
+ * @param distances The distances between the vertices, 0 for missing edges. They must be symmetric.
+ * @param root The dense index of the vertex every tour starts and ends at.
+ */
+
+    BranchAndBound(const DistanceOracle &distances, int root);
+
+/**
+ * @brief Searches for the shortest tour.
+ *
+ * @param path Receives the shortest tour found, as dense indices starting at the root.
+ * @param initial A tour of n vertices to start from, or nullptr. It is only used as the first upper bound if it is
+ * valid.
+ * @param timeLimit The most seconds to search, or 0 for no limit.
+ * @return The length of the shortest tour found, or -1 if there is no tour or the graph has more than MAX_VERTICES
+ * vertices.
+ */
+
+    double solve(int path[], const int *initial = nullptr, double timeLimit = 0);
+
+/**
+ * @brief Checks if the last search proved its tour optimal.
+ *
+ * @return False if the search ran out of time, true otherwise.
+ */
+
+    bool isOptimal() const;
+
+/**
+ * @brief Returns the number of nodes the last search bounded.
+ *
+ * @return The number of nodes.
+ */
+
+    size_t getNodes() const;
+
+private:
+
+/**
+ * @brief An open node of the best-first search.
+ */
+
+    struct Node {
+        double bound; /**< The lower bound of every tour through the node */
+        double cost; /**< The length of the path */
+        uint64_t visited; /**< The vertices of the path */
+        vector<uint8_t> path; /**< The vertices of the path, in order */
+    };
+
+/**
+ * @brief The vertices and the ends of a path from the root, which decide how it can be completed.
+ */
+
+    struct State {
+        uint64_t visited; /**< The vertices of the path */
+        uint16_t ends; /**< The second vertex of the path in the high byte, the last one in the low byte */
+
+        bool operator==(const State &other) const {
+            return visited == other.visited && ends == other.ends;
+        }
+    };
+
+/**
+ * @brief Hashes a State.
+ */
+
+    struct StateHash {
+        size_t operator()(const State &state) const {
+            return hash<uint64_t>()(state.visited * 0x9E3779B97F4A7C15ull ^ state.ends);
+        }
+    };
+
+    static constexpr size_t TABLE_ENTRY_BYTES = 64; /**< Approximate memory of one entry of a hash table */
+
+    int n; /**< Number of vertices */
+    int root; /**< The vertex every tour starts and ends at */
+    vector<double> dist; /**< The n x n distances, infinity for missing edges */
+    double best; /**< The length of the shortest tour found */
+    vector<int> bestPath; /**< The shortest tour found */
+    size_t nodes = 0; /**< Nodes bounded by the last search */
+    size_t ticks = 0; /**< Calls to expired() since the search started */
+    bool optimal = true; /**< Whether the last search finished */
+    chrono::steady_clock::time_point deadline; /**< When the search stops, if limited */
+    bool limited = false; /**< Whether the search has a deadline */
+    vector<uint8_t> current; /**< The path of the depth-first search */
+    size_t tableCapacity = 0; /**< The most entries of each table */
+    unordered_map<uint64_t, double> trees; /**< The weight of the spanning tree of sets of unvisited vertices */
+    unordered_map<State, double, StateHash> shortest; /**< The length of the shortest path searched to each state */
+
+/**
+ * @brief Returns the distance between two vertices.
+ *
+ * @param i The dense index of the first vertex.
+ * @param j The dense index of the second vertex.
+ * @return The distance, infinity if they are not adjacent.
+ */
+
+    double d(int i, int j) const {
+        return dist[(size_t) i * n + j];
+    }
+
+/**
+ * @brief Computes the lower bound of the tours that continue a path.
+ *
+ * @param last The vertex the path ends at.
+ * @param unvisited The vertices the path has not visited.
+ * @return The length the rest of any such tour has at least, infinity if there is none.
+ * @complexity O(|V|^2)
+ */
+
+    double remainder(int last, uint64_t unvisited);
+
+/**
+ * @brief Returns the weight of the minimum spanning tree of a set of vertices.
+ *
+ * @param vertices The vertices, as a mask.
+ * @return The weight of the tree, infinity if the vertices are not connected.
+ * @complexity O(|V|^2), O(1) when the set was seen before.
+ */
+
+    double spanningTree(uint64_t vertices);
+
+/**
+ * @brief Checks if a path is beaten by another one that visits the same vertices, and records it otherwise.
+ *
+ * @param visited The vertices of the path.
+ * @param second The second vertex of the path.
+ * @param last The last vertex of the path.
+ * @param cost The length of the path.
+ * @return True if a path at most as long with the same vertices and ends was already searched.
+ */
+
+    bool dominated(uint64_t visited, int second, int last, double cost);
+
+/**
+ * @brief Improves a tour with 2-opt moves until none shortens it, and keeps it if it is the best so far.
+ *
+ * @param tour The tour. It is ignored unless it visits every vertex once along existing edges.
+ */
+
+    void improve(vector<int> tour);
+
+/**
+ * @brief Records a tour that closes a path, if it is shorter than the best one.
+ *
+ * @param path The vertices of the path, all n of them.
+ * @param cost The length of the tour, including the edge back to the root.
+ */
+
+    void record(const vector<uint8_t> &path, double cost);
+
+/**
+ * @brief Returns the vertices a path may continue to, nearest first.
+ *
+ * @param path The vertices of the path.
+ * @param visited The vertices of the path, as a mask.
+ * @return The unvisited vertices adjacent to the end of the path, without those that would repeat a tour backwards.
+ */
+
+    vector<int> children(const vector<uint8_t> &path, uint64_t visited) const;
+
+/**
+ * @brief Searches the subtree of a node depth-first.
+ *
+ * @param cost The length of the path in current.
+ * @param visited The vertices of the path in current.
+ */
+
+    void depthFirst(double cost, uint64_t visited);
+
+/**
+ * @brief Checks the deadline every few thousand nodes.
+ *
+ * @return True if the search must stop.
+ */
+
+    bool expired();
+};
+
+
+#endif //DA___2ND_PROJECT_BRANCHANDBOUND_H
@@ -0,0 +1,173 @@
+//
+// Created by oem on 11/06/23.
+//
+
+#include "CandidateSet.h"
+#include "Graph.h"
+#include "DistanceOracle.h"
+#include "SpatialIndex.h"
+#include "Parallel.h"
+#include <cmath>
+#include <memory>
+
+/**
+ * @brief Returns the quadrant of a vertex as seen from another.
+ *
+ * @param graph The graph, loaded with coordinates.
+ * @param v The vertex the quadrants are centred on.
+ * @param u The other vertex.
+ * @return 0 to 3, from the signs of the latitude and the (wrapped) longitude differences.
+ */
+
+static int quadrantOf(const Graph &graph, int v, int u) {
+    double dLat = graph.vertexAt(u)->getLatitude() - graph.vertexAt(v)->getLatitude();
+    double dLon = remainder(graph.vertexAt(u)->getLongitude() - graph.vertexAt(v)->getLongitude(), 360.0);
+    return (dLat >= 0 ? 0 : 2) + (dLon >= 0 ? 0 : 1);
+}
+
+/**
+ * @brief Computes the candidates of every vertex of a graph, in parallel.
+ *
+ * Each vertex gathers a pool of possible candidates: its neighbours, which are the only vertices with a known
+ * distance on incomplete graphs, plus on geo graphs the vertices nearest to it on the sphere, or every vertex on a
+ * metric closure. Neighbours are
+ * measured by their edge weight, not their haversine distance, so the spatial query asks for k + degree vertices
+ * (4k + degree for QUADRANT) to be sure the k nearest by the oracle are in the pool. The pool is then ranked by
+ * distance, ties going to the smaller index.
+ *
+ * @param graph The loaded graph.
+ * @param k The most candidates per vertex.
+ * @param strategy How the candidates are chosen.
+ * @complexity O(n (k + degree) log n) on geo graphs, O(n^2 log n) on a metric closure, O(|E| log |E|) otherwise,
+ * divided among the worker threads.
+ */
+
+void CandidateSet::build(const Graph &graph, int k, Strategy strategy) {
+    int n = graph.getNumVertex();
+    this->k = k = max(0, min(k, n - 1));
+    DistanceOracle oracle(graph);
+    const CompactGraph &adjacency = graph.getAdjacency();
+    unique_ptr<SpatialIndex> spatial;
+    if (oracle.isGeometric()) {
+        spatial = make_unique<SpatialIndex>(graph);
+    }
+    // A metric closure has no spatial structure to search, every vertex is in the pool
+    bool everyVertex = oracle.isComplete() && spatial == nullptr;
+    bool quadrants = strategy == QUADRANT && graph.hasCoordinates();
+
+    // Every vertex writes its candidates to its own k slots, compacted afterwards
+    vector<int> slotTargets((size_t) n * k);
+    vector<double> slotDistances((size_t) n * k);
+    vector<uint32_t> counts(n, 0);
+    parallelFor(n, 256, [&](size_t begin, size_t end) {
+        vector<int> pool;
+        vector<pair<double, int>> ranked;
+        vector<uint8_t> taken;
+        for (int v = (int) begin; v < (int) end; v++) {
+            NeighbourView edges = adjacency.neighbours(v);
+            pool.assign(edges.targets(), edges.targets() + edges.size());
+            if (everyVertex) {
+                pool.resize(n);
+                for (int u = 0; u < n; u++) {
+                    pool[u] = u;
+                }
+            }
+            else if (spatial) {
+                vector<int> near = spatial->nearest(v, (quadrants ? 4 * k : k) + (int) edges.size());
+                pool.insert(pool.end(), near.begin(), near.end());
+            }
+            sort(pool.begin(), pool.end());
+            pool.erase(unique(pool.begin(), pool.end()), pool.end());
+
+            ranked.clear();
+            for (int u : pool) {
+                if (u != v) {
+                    ranked.emplace_back(oracle(v, u), u);
+                }
+            }
+            if (!quadrants && ranked.size() > (size_t) k) {
+                partial_sort(ranked.begin(), ranked.begin() + k, ranked.end());
+                ranked.resize(k);
+            }
+            else {
+                sort(ranked.begin(), ranked.end());
+            }
+
+            int *outTargets = slotTargets.data() + (size_t) v * k;
+            double *outDistances = slotDistances.data() + (size_t) v * k;
+            uint32_t count = 0;
+            taken.assign(ranked.size(), 0);
+            if (quadrants) {
+                // The nearest k / 4 of each quadrant first, then the nearest of the rest
+                int quota[4];
+                fill(quota, quota + 4, (k + 3) / 4);
+                for (size_t r = 0; r < ranked.size() && (int) count < k; r++) {
+                    int q = quadrantOf(graph, v, ranked[r].second);
+                    if (quota[q] > 0) {
+                        quota[q]--;
+                        taken[r] = 1;
+                        count++;
+                    }
+                }
+            }
+            for (size_t r = 0; r < ranked.size() && (int) count < k; r++) {
+                if (!taken[r]) {
+                    taken[r] = 1;
+                    count++;
+                }
+            }
+            count = 0;
+            for (size_t r = 0; r < ranked.size(); r++) {
+                if (taken[r]) {
+                    outTargets[count] = ranked[r].second;
+                    outDistances[count] = ranked[r].first;
+                    count++;
+                }
+            }
+            counts[v] = count;
+        }
+    });
+
+    offsets.assign(n + 1, 0);
+    for (int v = 0; v < n; v++) {
+        offsets[v + 1] = offsets[v] + counts[v];
+    }
+    targets.resize(offsets[n]);
+    distances.resize(offsets[n]);
+    for (int v = 0; v < n; v++) {
+        copy(slotTargets.begin() + (size_t) v * k, slotTargets.begin() + (size_t) v * k + counts[v],
+             targets.begin() + offsets[v]);
+        copy(slotDistances.begin() + (size_t) v * k, slotDistances.begin() + (size_t) v * k + counts[v],
+             distances.begin() + offsets[v]);
+    }
+}
+
+/**
+ * @brief Checks if the candidates were computed.
+ *
+ * @return True if build() was not called, false otherwise.
+ */
+
+bool CandidateSet::empty() const {
+    return offsets.empty();
+}
+
+/**
+ * @brief Returns the most candidates a vertex can have.
+ *
+ * @return The k given to build().
+ */
+
+int CandidateSet::getK() const {
+    return k;
+}
+
+/**
+ * @brief Returns the memory held by the lists.
+ *
+ * @return The number of bytes.
+ */
+
+size_t CandidateSet::memoryUsage() const {
+    return offsets.size() * sizeof(uint32_t) + targets.size() * (sizeof(int) + sizeof(double));
+}
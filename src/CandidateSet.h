@@ -0,0 +1,102 @@
+//
+// Created by oem on 11/06/23.
+//
+
+#ifndef DA___2ND_PROJECT_CANDIDATESET_H
+#define DA___2ND_PROJECT_CANDIDATESET_H
+
+#include <cstdint>
+#include <vector>
+#include "CompactGraph.h"
+
+using namespace std;
+
+class Graph;
+
+/**
+ * @brief The CandidateSet class holds, for every vertex, a short list of the vertices nearest to it.
+ *
+ * Improvement steps and pruning rules that only consider these candidates look at O(nk) pairs instead of O(n^2).
+ * The lists are stored like a CompactGraph, one contiguous run of targets and distances per vertex, nearest first,
+ * and are read through the same NeighbourView, the weight of each entry being the distance to the candidate.
+ */
+
+class CandidateSet {
+public:
+
+/**
+ * @brief How the candidates of a vertex are chosen.
+ */
+
+    enum Strategy {
+        NEAREST, /**< The k nearest vertices */
+        QUADRANT /**< The nearest vertices of each quadrant around the vertex first, so clustered instances keep
+                  * candidates in every direction; the same as NEAREST on graphs without coordinates */
+    };
+
+/**
+ * The number of candidates per vertex used when none is given.
+ */
+
+    static constexpr int DEFAULT_K = 8;
+
+/**
+ * @brief Computes the candidates of every vertex of a graph, in parallel.
+ *
+ * Distances are those of a DistanceOracle over the graph. On graphs with coordinates and no distance matrix every
+ * vertex is a potential candidate and the search goes through a SpatialIndex; on a metric closure every vertex is
+ * ranked; on other graphs only the vertices with a known distance, i.e. the neighbours, are candidates.
+ *
+ * @param graph The loaded graph.
+ * @param k The most candidates per vertex.
+ * @param strategy How the candidates are chosen.
+ * @complexity O(n (k + degree) log n) on geo graphs, O(n^2 log n) on a metric closure, O(|E| log |E|) otherwise,
+ * divided among the worker threads.
+ */
+
+    void build(const Graph &graph, int k = DEFAULT_K, Strategy strategy = NEAREST);
+
+/**
+ * @brief Returns the candidates of a vertex.
+ *
+ * @param v The dense index of the vertex.
+ * @return The candidates, nearest first, each with its distance as the weight.
+ */
+
+    NeighbourView of(int v) const {
+        return {targets.data() + offsets[v], distances.data() + offsets[v], offsets[v + 1] - offsets[v]};
+    }
+
+/**
+ * @brief Checks if the candidates were computed.
+ *
+ * @return True if build() was not called, false otherwise.
+ */
+
+    bool empty() const;
+
+/**
+ * @brief Returns the most candidates a vertex can have.
+ *
+ * @return The k given to build().
+ */
+
+    int getK() const;
+
+/**
+ * @brief Returns the memory held by the lists.
+ *
+ * @return The number of bytes.
+ */
+
+    size_t memoryUsage() const;
+
+private:
+    int k = 0; /**< The most candidates per vertex */
+    vector<uint32_t> offsets; /**< The candidates of v are at [offsets[v], offsets[v + 1]) */
+    vector<int> targets; /**< The candidate vertices */
+    vector<double> distances; /**< The distance to each candidate */
+};
+
+
+#endif //DA___2ND_PROJECT_CANDIDATESET_H
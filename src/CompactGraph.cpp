@@ -0,0 +1,147 @@
+//
+// Created by oem on 04/06/23.
+//
+
+#include "CompactGraph.h"
+
+/**
+ * @brief Adds a vertex with no edges.
+ *
+ * @return The index of the new vertex.
+ */
+
+int CompactGraph::addVertex() {
+    offsets.push_back(0);
+    return (int) offsets.size() - 2;
+}
+
+/**
+ * @brief Counts an undirected edge before the arrays are allocated.
+ *
+ * @param u The index of one endpoint.
+ * @param v The index of the other endpoint.
+ */
+
+void CompactGraph::countEdge(int u, int v) {
+    offsets[u + 1]++;
+    offsets[v + 1]++;
+}
+
+/**
+ * @brief Sizes the edge array for every edge counted so far, in a single allocation.
+ *
+ * Turns the degree counts into offsets with a prefix sum.
+ */
+
+void CompactGraph::allocate() {
+    for (size_t u = 1; u < offsets.size(); u++) {
+        offsets[u] += offsets[u - 1];
+    }
+    targets.resize(offsets.back());
+    weights.resize(offsets.back());
+    cursor.assign(offsets.begin(), offsets.end() - 1);
+}
+
+/**
+ * @brief Places an undirected edge that was counted before allocate().
+ *
+ * @param u The index of one endpoint.
+ * @param v The index of the other endpoint.
+ * @param w The weight of the edge.
+ */
+
+void CompactGraph::addEdge(int u, int v, double w) {
+    uint32_t slot = cursor[u]++;
+    targets[slot] = v;
+    weights[slot] = w;
+    slot = cursor[v]++;
+    targets[slot] = u;
+    weights[slot] = w;
+}
+
+/**
+ * @brief Replaces the whole adjacency with arrays built elsewhere.
+ *
+ * @param newOffsets The n + 1 edge offsets.
+ * @param newTargets The destination of every edge, grouped by vertex.
+ * @param newWeights The weight of every edge, in the same order.
+ */
+
+void CompactGraph::assign(vector<uint32_t> &&newOffsets, vector<int> &&newTargets, vector<double> &&newWeights) {
+    offsets = std::move(newOffsets);
+    targets = std::move(newTargets);
+    weights = std::move(newWeights);
+    cursor.clear();
+}
+
+/**
+ * @brief Returns the number of vertices.
+ *
+ * @return The number of vertices.
+ */
+
+int CompactGraph::getNumVertex() const {
+    return (int) offsets.size() - 1;
+}
+
+/**
+ * @brief Returns the number of directed edges, twice the number of undirected ones.
+ *
+ * @return The number of directed edges.
+ */
+
+size_t CompactGraph::getNumEdges() const {
+    return targets.size();
+}
+
+/**
+ * @brief Returns the number of edges of a vertex.
+ *
+ * @param u The index of the vertex.
+ * @return The degree of u.
+ */
+
+int CompactGraph::getDegree(int u) const {
+    return (int) (offsets[u + 1] - offsets[u]);
+}
+
+/**
+ * @brief Returns the edge offsets of every vertex.
+ *
+ * @return The n + 1 offsets.
+ */
+
+const vector<uint32_t> &CompactGraph::getOffsets() const {
+    return offsets;
+}
+
+/**
+ * @brief Returns the destination of every edge.
+ *
+ * @return The destinations, grouped by vertex.
+ */
+
+const vector<int> &CompactGraph::getTargets() const {
+    return targets;
+}
+
+/**
+ * @brief Returns the weight of every edge.
+ *
+ * @return The weights, grouped by vertex.
+ */
+
+const vector<double> &CompactGraph::getWeights() const {
+    return weights;
+}
+
+/**
+ * @brief Returns the memory held by the adjacency.
+ *
+ * @return The size of the arrays in bytes.
+ */
+
+size_t CompactGraph::memoryUsage() const {
+    return offsets.capacity() * sizeof(uint32_t) + cursor.capacity() * sizeof(uint32_t)
+           + targets.capacity() * sizeof(int) + weights.capacity() * sizeof(double);
+}
@@ -0,0 +1,284 @@
+//
+// Created by oem on 04/06/23.
+//
+
+#ifndef DA___2ND_PROJECT_COMPACTGRAPH_H
+#define DA___2ND_PROJECT_COMPACTGRAPH_H
+
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief One directed half of an undirected edge in a CompactGraph, as read through a NeighbourView.
+ */
+
+struct CompactEdge {
+    int dest; /**< Index of the destination vertex */
+    double weight; /**< The weight of the edge */
+};
+
+/**
+ * @brief The NeighbourView class is a non-owning view of the edges of one vertex of a CompactGraph.
+ *
+ * It holds two pointers into the graph's target and weight arrays and a count, so taking a view copies nothing and
+ * iterating it reads both arrays front to back. Views stay valid until the graph is modified.
+ */
+
+class NeighbourView {
+public:
+
+/**
+ * @brief Iterates the edges of a view, yielding each as a CompactEdge value.
+ */
+
+    class iterator {
+    public:
+        iterator(const int *target, const double *weight) : target(target), weight(weight) {}
+
+        CompactEdge operator*() const {
+            return {*target, *weight};
+        }
+
+        iterator &operator++() {
+            target++;
+            weight++;
+            return *this;
+        }
+
+        bool operator!=(const iterator &other) const {
+            return target != other.target;
+        }
+
+        bool operator==(const iterator &other) const {
+            return target == other.target;
+        }
+
+    private:
+        const int *target; /**< The current destination */
+        const double *weight; /**< The weight of the current edge */
+    };
+
+/**
+ * @brief Constructs a view.
+ *
+ * @param targets The first destination.
+ * @param weights The first weight.
+ * @param count The number of edges.
+ */
+
+    NeighbourView(const int *targets, const double *weights, size_t count) :
+        targetData(targets), weightData(weights), count(count) {}
+
+    iterator begin() const {
+        return {targetData, weightData};
+    }
+
+    iterator end() const {
+        return {targetData + count, weightData + count};
+    }
+
+/**
+ * @brief Returns the number of edges in the view.
+ *
+ * @return The degree of the vertex.
+ */
+
+    size_t size() const {
+        return count;
+    }
+
+/**
+ * @brief Returns the destination of an edge.
+ *
+ * @param k The position of the edge in the view.
+ * @return The index of the destination vertex.
+ */
+
+    int target(size_t k) const {
+        return targetData[k];
+    }
+
+/**
+ * @brief Returns the weight of an edge.
+ *
+ * @param k The position of the edge in the view.
+ * @return The weight of the edge.
+ */
+
+    double weight(size_t k) const {
+        return weightData[k];
+    }
+
+/**
+ * @brief Returns the destinations of every edge, contiguous.
+ *
+ * @return A pointer to size() destinations.
+ */
+
+    const int *targets() const {
+        return targetData;
+    }
+
+/**
+ * @brief Returns the weights of every edge, contiguous.
+ *
+ * @return A pointer to size() weights.
+ */
+
+    const double *weights() const {
+        return weightData;
+    }
+
+private:
+    const int *targetData; /**< The destinations of the edges */
+    const double *weightData; /**< The weights of the edges */
+    size_t count; /**< The number of edges */
+};
+
+/**
+ * @brief The CompactGraph class stores the adjacency of an undirected graph in compressed sparse row form.
+ *
+ * Vertices are numbered 0..n-1 and the edges of vertex u occupy positions [offsets[u], offsets[u + 1]) of two
+ * parallel arrays, one of destinations and one of weights. The graph is built
+ * in two passes: every edge is first counted with countEdge(), then allocate() sizes the arrays once, and every
+ * edge is placed with addEdge(). No memory is allocated per edge, and the graph cannot grow after allocate().
+ */
+
+class CompactGraph {
+public:
+
+/**
+ * @brief Adds a vertex with no edges.
+ *
+ * @return The index of the new vertex.
+ */
+
+    int addVertex();
+
+/**
+ * @brief Counts an undirected edge before the arrays are allocated.
+ *
+ * @param u The index of one endpoint.
+ * @param v The index of the other endpoint.
+ */
+
+    void countEdge(int u, int v);
+
+/**
+ * @brief Sizes the edge array for every edge counted so far, in a single allocation.
+ */
+
+    void allocate();
+
+/**
+ * @brief Places an undirected edge that was counted before allocate().
+ *
+ * @param u The index of one endpoint.
+ * @param v The index of the other endpoint.
+ * @param w The weight of the edge.
+ */
+
+    void addEdge(int u, int v, double w);
+
+/**
+ * @brief Replaces the whole adjacency with arrays built elsewhere.
+ *
+ * @param newOffsets The n + 1 edge offsets.
+ * @param newTargets The destination of every edge, grouped by vertex.
+ * @param newWeights The weight of every edge, in the same order.
+ */
+
+    void assign(vector<uint32_t> &&newOffsets, vector<int> &&newTargets, vector<double> &&newWeights);
+
+/**
+ * @brief Returns the number of vertices.
+ *
+ * @return The number of vertices.
+ */
+
+    int getNumVertex() const;
+
+/**
+ * @brief Returns the number of directed edges, twice the number of undirected ones.
+ *
+ * @return The number of directed edges.
+ */
+
+    size_t getNumEdges() const;
+
+/**
+ * @brief Returns the edges of a vertex without copying them.
+ *
+ * @param u The index of the vertex.
+ * @return A view of the outgoing edges of u.
+ */
+
+    NeighbourView neighbours(int u) const {
+        return {targets.data() + offsets[u], weights.data() + offsets[u], offsets[u + 1] - offsets[u]};
+    }
+
+/**
+ * @brief Returns the position of the first edge of a vertex in the edge arrays.
+ *
+ * Edge k of neighbours(u) is edge firstEdge(u) + k of the graph, which identifies it uniquely.
+ *
+ * @param u The index of the vertex.
+ * @return The offset of u's edges.
+ */
+
+    size_t firstEdge(int u) const {
+        return offsets[u];
+    }
+
+/**
+ * @brief Returns the edge offsets of every vertex.
+ *
+ * @return The n + 1 offsets.
+ */
+
+    const vector<uint32_t> &getOffsets() const;
+
+/**
+ * @brief Returns the destination of every edge.
+ *
+ * @return The destinations, grouped by vertex.
+ */
+
+    const vector<int> &getTargets() const;
+
+/**
+ * @brief Returns the weight of every edge.
+ *
+ * @return The weights, grouped by vertex.
+ */
+
+    const vector<double> &getWeights() const;
+
+/**
+ * @brief Returns the number of edges of a vertex.
+ *
+ * @param u The index of the vertex.
+ * @return The degree of u.
+ */
+
+    int getDegree(int u) const;
+
+/**
+ * @brief Returns the memory held by the adjacency.
+ *
+ * @return The size of the arrays in bytes.
+ */
+
+    size_t memoryUsage() const;
+
+private:
+    vector<uint32_t> offsets = {0}; /**< Degree counts before allocate(), edge offsets after it (n + 1 entries) */
+    vector<uint32_t> cursor; /**< Next free slot of each vertex while edges are placed */
+    vector<int> targets; /**< Destination of every outgoing edge, grouped by vertex */
+    vector<double> weights; /**< Weight of every outgoing edge, in the same order as targets */
+};
+
+
+#endif //DA___2ND_PROJECT_COMPACTGRAPH_H
@@ -0,0 +1,302 @@
+//
+// Created by oem on 09/06/23.
+//
+
+#include "CompressedStream.h"
+#include <cstdio>
+
+#ifdef DA_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef DA_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+/**
+ * Opens a file and starts decoding it.
+ *
+ * @param file_name The path to the file.
+ */
+
+CompressedStream::CompressedStream(const fs::path& file_name) : codec(codecOf(file_name)) {
+    if (!isSupported(codec)) {
+        return;
+    }
+#ifdef DA_HAVE_ZLIB
+    if (codec == GZIP) {
+        gzFile file = gzopen(file_name.c_str(), "rb");
+        if (file != nullptr) {
+            gzbuffer(file, 256 * 1024);
+        }
+        handle = file;
+    }
+#endif
+    if (codec != GZIP) {
+        handle = fopen(file_name.c_str(), "rb");
+    }
+    if (handle != nullptr) {
+        decoder = thread(&CompressedStream::decode, this);
+    }
+}
+
+/**
+ * Stops the decoder and closes the file.
+ */
+
+CompressedStream::~CompressedStream() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    changed.notify_all();
+    if (decoder.joinable()) {
+        decoder.join();
+    }
+    if (handle == nullptr) {
+        return;
+    }
+#ifdef DA_HAVE_ZLIB
+    if (codec == GZIP) {
+        gzclose(static_cast<gzFile>(handle));
+        return;
+    }
+#endif
+    fclose(static_cast<FILE *>(handle));
+}
+
+/**
+ * Gets the compression format of a file from its extension.
+ *
+ * @param file_name The path to the file.
+ * @return The codec used to read the file.
+ */
+
+CompressedStream::Codec CompressedStream::codecOf(const fs::path& file_name) {
+    fs::path extension = file_name.extension();
+    if (extension == ".gz") return GZIP;
+    if (extension == ".zst") return ZSTD;
+    return PLAIN;
+}
+
+/**
+ * Checks if this build can decode a format.
+ *
+ * @param codec The format.
+ * @return True if files in that format can be read, false otherwise.
+ */
+
+bool CompressedStream::isSupported(Codec codec) {
+    switch (codec) {
+        case GZIP:
+#ifdef DA_HAVE_ZLIB
+            return true;
+#else
+            return false;
+#endif
+        case ZSTD:
+#ifdef DA_HAVE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+        default:
+            return true;
+    }
+}
+
+/**
+ * Checks if the file was opened and its format is supported.
+ *
+ * @return True if blocks can be read, false otherwise.
+ */
+
+bool CompressedStream::isOpen() const {
+    return handle != nullptr;
+}
+
+/**
+ * Waits for the next decompressed block.
+ *
+ * @param block Receives the block; its previous contents are discarded.
+ * @return True if a block was read, false at the end of the file or after an error.
+ */
+
+bool CompressedStream::next(vector<char>& block) {
+    unique_lock<mutex> guard(lock);
+    changed.wait(guard, [this] { return !queue.empty() || done; });
+    if (queue.empty()) {
+        return false;
+    }
+    block = std::move(queue.front());
+    queue.pop_front();
+    guard.unlock();
+    changed.notify_all();
+    return true;
+}
+
+/**
+ * Checks if decoding stopped because of a read or format error.
+ *
+ * @return True if the file could not be decoded to the end, false otherwise.
+ */
+
+bool CompressedStream::failed() {
+    lock_guard<mutex> guard(lock);
+    return error || handle == nullptr;
+}
+
+/**
+ * Decodes the whole file into the queue. Runs on the decoder thread.
+ */
+
+void CompressedStream::decode() {
+    bool ok;
+    switch (codec) {
+        case GZIP:
+            ok = decodeGzip();
+            break;
+        case ZSTD:
+            ok = decodeZstd();
+            break;
+        default:
+            ok = decodePlain();
+    }
+    {
+        lock_guard<mutex> guard(lock);
+        done = true;
+        error = !ok && !stopping;
+    }
+    changed.notify_all();
+}
+
+/**
+ * Queues a decompressed block, waiting while the queue is full.
+ *
+ * @param block The block to queue.
+ * @return False if the caller asked the decoder to stop, true otherwise.
+ */
+
+bool CompressedStream::push(vector<char>&& block) {
+    unique_lock<mutex> guard(lock);
+    changed.wait(guard, [this] { return queue.size() < MAX_QUEUED || stopping; });
+    if (stopping) {
+        return false;
+    }
+    queue.push_back(std::move(block));
+    guard.unlock();
+    changed.notify_all();
+    return true;
+}
+
+/**
+ * Reads a whole file without decompressing it.
+ *
+ * @return True if the end of the file was reached without errors, false otherwise.
+ */
+
+bool CompressedStream::decodePlain() {
+    auto file = static_cast<FILE *>(handle);
+    while (true) {
+        vector<char> block(BLOCK_SIZE);
+        size_t count = fread(block.data(), 1, block.size(), file);
+        if (count == 0) {
+            return !ferror(file);
+        }
+        block.resize(count);
+        if (!push(std::move(block))) {
+            return false;
+        }
+    }
+}
+
+/**
+ * Decompresses a gzip file. Concatenated gzip members are read as one stream.
+ *
+ * @return True if the end of the file was reached without errors, false otherwise.
+ */
+
+bool CompressedStream::decodeGzip() {
+#ifdef DA_HAVE_ZLIB
+    auto file = static_cast<gzFile>(handle);
+    while (true) {
+        vector<char> block(BLOCK_SIZE);
+        int count = gzread(file, block.data(), (unsigned) block.size());
+        if (count < 0) {
+            return false;
+        }
+        if (count == 0) {
+            // A truncated file also ends here, with Z_BUF_ERROR
+            int status;
+            gzerror(file, &status);
+            return status == Z_OK;
+        }
+        block.resize(count);
+        if (!push(std::move(block))) {
+            return false;
+        }
+    }
+#else
+    return false;
+#endif
+}
+
+/**
+ * Decompresses a zstd file. Concatenated frames are read as one stream.
+ *
+ * @return True if the end of the file was reached without errors, false otherwise.
+ */
+
+bool CompressedStream::decodeZstd() {
+#ifdef DA_HAVE_ZSTD
+    auto file = static_cast<FILE *>(handle);
+    ZSTD_DStream *stream = ZSTD_createDStream();
+    if (stream == nullptr) {
+        return false;
+    }
+    ZSTD_initDStream(stream);
+    vector<char> input(ZSTD_DStreamInSize());
+    vector<char> block(BLOCK_SIZE);
+    ZSTD_outBuffer out = {block.data(), block.size(), 0};
+    size_t pending = 0;
+    bool ok = true;
+    while (ok) {
+        size_t count = fread(input.data(), 1, input.size(), file);
+        if (count == 0) {
+            // Flush what the decoder still holds; without progress the last frame is truncated
+            ZSTD_inBuffer in = {input.data(), 0, 0};
+            while (ok && pending != 0) {
+                size_t before = out.pos;
+                pending = ZSTD_decompressStream(stream, &out, &in);
+                if (ZSTD_isError(pending) || (pending != 0 && out.pos == before)) {
+                    ok = false;
+                } else if (out.pos == out.size) {
+                    ok = push(std::move(block));
+                    block.assign(BLOCK_SIZE, 0);
+                    out = {block.data(), block.size(), 0};
+                }
+            }
+            ok = ok && !ferror(file);
+            break;
+        }
+        ZSTD_inBuffer in = {input.data(), count, 0};
+        while (ok && in.pos < in.size) {
+            pending = ZSTD_decompressStream(stream, &out, &in);
+            if (ZSTD_isError(pending)) {
+                ok = false;
+            } else if (out.pos == out.size) {
+                ok = push(std::move(block));
+                block.assign(BLOCK_SIZE, 0);
+                out = {block.data(), block.size(), 0};
+            }
+        }
+    }
+    if (ok && out.pos > 0) {
+        block.resize(out.pos);
+        ok = push(std::move(block));
+    }
+    ZSTD_freeDStream(stream);
+    return ok;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,164 @@
+//
+// Created by oem on 09/06/23.
+//
+
+#ifndef DA___2ND_PROJECT_COMPRESSEDSTREAM_H
+#define DA___2ND_PROJECT_COMPRESSEDSTREAM_H
+
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace std;
+
+/**
+ * @brief The CompressedStream class reads a file as a sequence of decompressed blocks.
+ *
+ * A decoder thread reads and decompresses the file while the caller parses the blocks it already produced, so
+ * decoding and parsing overlap. At most MAX_QUEUED blocks wait in between, which bounds the memory used no matter
+ * how large the file is. Files ending in .gz are read with zlib and files ending in .zst with zstd, when the build
+ * has them; any other file is read as is.
+ */
+
+class CompressedStream {
+public:
+
+/**
+ * @brief The compression formats recognised by file extension.
+ */
+
+    enum Codec {
+        PLAIN, /**< Not compressed */
+        GZIP, /**< .gz, decoded with zlib */
+        ZSTD /**< .zst, decoded with zstd */
+    };
+
+/**
+ * The size of the decompressed blocks handed to the caller.
+ */
+
+    static constexpr size_t BLOCK_SIZE = 1 << 20;
+
+/**
+ * The number of decompressed blocks that may wait for the caller before the decoder pauses.
+ */
+
+    static constexpr size_t MAX_QUEUED = 4;
+
+/**
+ * Opens a file and starts decoding it.
+ *
+ * @param file_name The path to the file.
+ */
+
+    explicit CompressedStream(const fs::path& file_name);
+
+/**
+ * Stops the decoder and closes the file.
+ */
+
+    ~CompressedStream();
+
+    CompressedStream(const CompressedStream&) = delete;
+    CompressedStream& operator=(const CompressedStream&) = delete;
+
+/**
+ * Gets the compression format of a file from its extension.
+ *
+ * @param file_name The path to the file.
+ * @return The codec used to read the file.
+ */
+
+    static Codec codecOf(const fs::path& file_name);
+
+/**
+ * Checks if this build can decode a format.
+ *
+ * @param codec The format.
+ * @return True if files in that format can be read, false otherwise.
+ */
+
+    static bool isSupported(Codec codec);
+
+/**
+ * Checks if the file was opened and its format is supported.
+ *
+ * @return True if blocks can be read, false otherwise.
+ */
+
+    bool isOpen() const;
+
+/**
+ * Waits for the next decompressed block.
+ *
+ * @param block Receives the block; its previous contents are discarded.
+ * @return True if a block was read, false at the end of the file or after an error.
+ */
+
+    bool next(vector<char>& block);
+
+/**
+ * Checks if decoding stopped because of a read or format error.
+ *
+ * @return True if the file could not be decoded to the end, false otherwise.
+ */
+
+    bool failed();
+
+private:
+    Codec codec; /**< The format of the file */
+    void *handle = nullptr; /**< The open FILE* or gzFile, nullptr if the file could not be opened */
+    mutex lock; /**< Guards every member below */
+    condition_variable changed; /**< Signalled whenever a block is queued or taken, or decoding ends */
+    deque<vector<char>> queue; /**< Decompressed blocks not yet taken by the caller */
+    bool done = false; /**< Whether the decoder finished */
+    bool error = false; /**< Whether the decoder hit an error */
+    bool stopping = false; /**< Whether the caller asked the decoder to stop early */
+    thread decoder; /**< The thread running decode() */
+
+/**
+ * Decodes the whole file into the queue. Runs on the decoder thread.
+ */
+
+    void decode();
+
+/**
+ * Queues a decompressed block, waiting while the queue is full.
+ *
+ * @param block The block to queue.
+ * @return False if the caller asked the decoder to stop, true otherwise.
+ */
+
+    bool push(vector<char>&& block);
+
+/**
+ * Reads a whole file without decompressing it.
+ *
+ * @return True if the end of the file was reached without errors, false otherwise.
+ */
+
+    bool decodePlain();
+
+/**
+ * Decompresses a gzip file.
+ *
+ * @return True if the end of the file was reached without errors, false otherwise.
+ */
+
+    bool decodeGzip();
+
+/**
+ * Decompresses a zstd file.
+ *
+ * @return True if the end of the file was reached without errors, false otherwise.
+ */
+
+    bool decodeZstd();
+};
+
+
+#endif //DA___2ND_PROJECT_COMPRESSEDSTREAM_H
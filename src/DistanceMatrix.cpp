@@ -0,0 +1,190 @@
+//
+// Created by oem on 07/06/23.
+//
+
+#include "DistanceMatrix.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+
+/**
+ * @brief Constructs a matrix of zeros.
+ *
+ * @param n The number of vertices.
+ * @param precision The precision of the stored entries.
+ * @param maxValue The largest distance that will be stored, used as the quantization scale.
+ */
+
+DistanceMatrix::DistanceMatrix(int n, Precision precision, double maxValue) : n(n), precision(precision) {
+    if (precision == QUANTIZED) {
+        scale = maxValue > 0 ? maxValue / UINT16_MAX : 1.0;
+    }
+    // aligned_alloc wants a multiple of the alignment; all-zero bytes read as 0 in every precision
+    size_t bytes = (memoryUsage() + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    storage.reset(aligned_alloc(ALIGNMENT, max(bytes, ALIGNMENT)));
+    if (storage == nullptr) {
+        throw bad_alloc();
+    }
+    memset(storage.get(), 0, bytes);
+    values = storage.get();
+}
+
+/**
+ * @brief Constructs a read-only matrix over entries stored in a mapped file.
+ *
+ * @param n The number of vertices.
+ * @param precision The precision of the stored entries.
+ * @param scale The distance of one quantization step, ignored for other precisions.
+ * @param file The mapping, which must hold n(n-1)/2 entries at the given offset.
+ * @param offset The position of the first entry in the mapping, aligned to the entry size.
+ */
+
+DistanceMatrix::DistanceMatrix(int n, Precision precision, double scale, unique_ptr<MappedFile> file, size_t offset) :
+    n(n),
+    precision(precision),
+    scale(precision == QUANTIZED ? scale : 0),
+    values(file->data() + offset),
+    mapping(std::move(file))
+    {}
+
+/**
+ * @brief Reads the precision requested by the DA_MATRIX environment variable.
+ *
+ * @return FLOAT for "float", QUANTIZED for "quantized", DOUBLE otherwise.
+ */
+
+DistanceMatrix::Precision DistanceMatrix::defaultPrecision() {
+    const char *value = getenv("DA_MATRIX");
+    if (value == nullptr) return DOUBLE;
+    string name(value);
+    if (name == "float") return FLOAT;
+    if (name == "quantized") return QUANTIZED;
+    return DOUBLE;
+}
+
+/**
+ * @brief Returns the size of one stored entry.
+ *
+ * @param precision The precision of the entries.
+ * @return The number of bytes per pair of vertices.
+ */
+
+size_t DistanceMatrix::bytesPerEntry(Precision precision) {
+    switch (precision) {
+        case DOUBLE:
+            return sizeof(double);
+        case FLOAT:
+            return sizeof(float);
+        default:
+            return sizeof(uint16_t);
+    }
+}
+
+/**
+ * @brief Stores an entry.
+ *
+ * Positive distances are quantized to at least one step, so they still read as adjacent. Different entries may be
+ * stored from different threads at the same time.
+ *
+ * @param k The position in the packed triangle.
+ * @param value The distance, between 0 and the maxValue given to the constructor.
+ */
+
+void DistanceMatrix::setEntry(size_t k, double value) {
+    switch (precision) {
+        case DOUBLE:
+            static_cast<double *>(storage.get())[k] = value;
+            break;
+        case FLOAT:
+            static_cast<float *>(storage.get())[k] = (float) value;
+            break;
+        default:
+            uint16_t steps = 0;
+            if (value > 0) {
+                steps = (uint16_t) max(1.0, min(round(value / scale), (double) UINT16_MAX));
+            }
+            static_cast<uint16_t *>(storage.get())[k] = steps;
+    }
+}
+
+/**
+ * @brief Returns the number of vertices.
+ *
+ * @return The number of vertices.
+ */
+
+int DistanceMatrix::getNumVertex() const {
+    return n;
+}
+
+/**
+ * @brief Returns the number of stored entries.
+ *
+ * @return n(n-1)/2.
+ */
+
+size_t DistanceMatrix::getNumEntries() const {
+    return n < 2 ? 0 : (size_t) n * (n - 1) / 2;
+}
+
+/**
+ * @brief Returns the precision of the stored entries.
+ *
+ * @return The precision.
+ */
+
+DistanceMatrix::Precision DistanceMatrix::getPrecision() const {
+    return precision;
+}
+
+/**
+ * @brief Returns the distance of one quantization step.
+ *
+ * @return The scale of QUANTIZED entries, 0 for other precisions.
+ */
+
+double DistanceMatrix::getScale() const {
+    return scale;
+}
+
+/**
+ * @brief Returns the stored entries, in the layout of the chosen precision.
+ *
+ * @return A pointer to memoryUsage() bytes.
+ */
+
+const void * DistanceMatrix::data() const {
+    return values;
+}
+
+/**
+ * @brief Checks if the entries live in a mapped file.
+ *
+ * @return True if the matrix is a read-only view of a file, false if it owns its entries.
+ */
+
+bool DistanceMatrix::isMapped() const {
+    return mapping != nullptr;
+}
+
+/**
+ * @brief Returns the memory held by the entries.
+ *
+ * @return The number of bytes.
+ */
+
+size_t DistanceMatrix::memoryUsage() const {
+    return getNumEntries() * bytesPerEntry(precision);
+}
+
+/**
+ * @brief Frees a block obtained from aligned_alloc.
+ *
+ * @param block The block, or nullptr.
+ */
+
+void DistanceMatrix::AlignedFree::operator()(void *block) const {
+    free(block);
+}
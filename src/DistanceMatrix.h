@@ -0,0 +1,232 @@
+//
+// Created by oem on 07/06/23.
+//
+
+#ifndef DA___2ND_PROJECT_DISTANCEMATRIX_H
+#define DA___2ND_PROJECT_DISTANCEMATRIX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "MappedFile.h"
+
+using namespace std;
+
+/**
+ * @brief The DistanceMatrix class stores the distances of a symmetric graph as its packed upper triangle.
+ *
+ * The diagonal is not stored, so n vertices take n(n-1)/2 entries. Entries are kept as doubles, floats or 16-bit
+ * integers scaled to the largest distance, for 2, 4 or 8 times less memory than a full matrix of doubles. A distance
+ * of 0 means the vertices are not adjacent; quantization never rounds a positive distance down to 0.
+ *
+ * The entries either live in one cache-line-aligned block owned by the matrix or in a read-only mapping of a cache
+ * file, which every process that maps the same file shares through the page cache. Row i of the triangle, the pairs
+ * (i, j) with j > i, is contiguous and starts at rowStart(i).
+ */
+
+class DistanceMatrix {
+public:
+
+/**
+ * @brief The precision of the stored entries.
+ */
+
+    enum Precision {
+        DOUBLE, /**< 8 bytes per pair, exact */
+        FLOAT, /**< 4 bytes per pair, about 7 significant digits */
+        QUANTIZED /**< 2 bytes per pair, absolute error up to a 131070th of the largest distance */
+    };
+
+/**
+ * @brief Constructs a matrix of zeros.
+ *
+ * @param n The number of vertices.
+ * @param precision The precision of the stored entries.
+ * @param maxValue The largest distance that will be stored, used as the quantization scale.
+ */
+
+    DistanceMatrix(int n, Precision precision, double maxValue);
+
+/**
+ * @brief Constructs a read-only matrix over entries stored in a mapped file.
+ *
+ * @param n The number of vertices.
+ * @param precision The precision of the stored entries.
+ * @param scale The distance of one quantization step, ignored for other precisions.
+ * @param file The mapping, which must hold n(n-1)/2 entries at the given offset.
+ * @param offset The position of the first entry in the mapping, aligned to the entry size.
+ */
+
+    DistanceMatrix(int n, Precision precision, double scale, unique_ptr<MappedFile> file, size_t offset);
+
+    static constexpr size_t ALIGNMENT = 64; /**< Alignment of owned entries, one cache line */
+
+    DistanceMatrix(const DistanceMatrix&) = delete;
+    DistanceMatrix& operator=(const DistanceMatrix&) = delete;
+
+/**
+ * @brief Reads the precision requested by the DA_MATRIX environment variable.
+ *
+ * @return FLOAT for "float", QUANTIZED for "quantized", DOUBLE otherwise.
+ */
+
+    static Precision defaultPrecision();
+
+/**
+ * @brief Returns the size of one stored entry.
+ *
+ * @param precision The precision of the entries.
+ * @return The number of bytes per pair of vertices.
+ */
+
+    static size_t bytesPerEntry(Precision precision);
+
+/**
+ * @brief Returns the position of a pair of distinct vertices in the packed triangle.
+ *
+ * @param i The dense index of one vertex.
+ * @param j The dense index of the other vertex.
+ * @return The entry that holds their distance.
+ */
+
+    size_t entryOf(int i, int j) const {
+        if (i > j) {
+            int t = i;
+            i = j;
+            j = t;
+        }
+        return rowStart(i) + (j - i - 1);
+    }
+
+/**
+ * @brief Returns the position of the first entry of a row of the packed triangle.
+ *
+ * @param i The dense index of a vertex.
+ * @return The entry that holds the distance between i and i + 1; the row has n - i - 1 entries.
+ */
+
+    size_t rowStart(int i) const {
+        return (size_t) i * (2 * (size_t) n - i - 1) / 2;
+    }
+
+/**
+ * @brief Returns the distance between two vertices.
+ *
+ * @param i The dense index of the first vertex.
+ * @param j The dense index of the second vertex.
+ * @return The distance, or 0 if the vertices are not adjacent.
+ */
+
+    double operator()(int i, int j) const {
+        if (i == j) {
+            return 0;
+        }
+        return entry(entryOf(i, j));
+    }
+
+/**
+ * @brief Returns a stored entry.
+ *
+ * @param k The position in the packed triangle.
+ * @return The distance stored there.
+ */
+
+    double entry(size_t k) const {
+        switch (precision) {
+            case DOUBLE:
+                return static_cast<const double *>(values)[k];
+            case FLOAT:
+                return static_cast<const float *>(values)[k];
+            default:
+                return static_cast<const uint16_t *>(values)[k] * scale;
+        }
+    }
+
+/**
+ * @brief Stores an entry. Only valid for matrices that own their entries.
+ *
+ * Different entries may be stored from different threads at the same time.
+ *
+ * @param k The position in the packed triangle.
+ * @param value The distance, between 0 and the maxValue given to the constructor.
+ */
+
+    void setEntry(size_t k, double value);
+
+/**
+ * @brief Returns the number of vertices.
+ *
+ * @return The number of vertices.
+ */
+
+    int getNumVertex() const;
+
+/**
+ * @brief Returns the number of stored entries.
+ *
+ * @return n(n-1)/2.
+ */
+
+    size_t getNumEntries() const;
+
+/**
+ * @brief Returns the precision of the stored entries.
+ *
+ * @return The precision.
+ */
+
+    Precision getPrecision() const;
+
+/**
+ * @brief Returns the distance of one quantization step.
+ *
+ * @return The scale of QUANTIZED entries, 0 for other precisions.
+ */
+
+    double getScale() const;
+
+/**
+ * @brief Returns the stored entries, in the layout of the chosen precision.
+ *
+ * @return A pointer to memoryUsage() bytes.
+ */
+
+    const void * data() const;
+
+/**
+ * @brief Checks if the entries live in a mapped file.
+ *
+ * @return True if the matrix is a read-only view of a file, false if it owns its entries.
+ */
+
+    bool isMapped() const;
+
+/**
+ * @brief Returns the memory held by the entries.
+ *
+ * @return The number of bytes.
+ */
+
+    size_t memoryUsage() const;
+
+private:
+
+/**
+ * @brief Frees a block obtained from aligned_alloc.
+ */
+
+    struct AlignedFree {
+        void operator()(void *block) const;
+    };
+
+    int n; /**< Number of vertices */
+    Precision precision; /**< The type of the entries: double, float or uint16_t multiples of scale */
+    double scale = 0; /**< Distance of one quantization step */
+    unique_ptr<void, AlignedFree> storage; /**< The owned entries, if the matrix is not mapped */
+    const void *values = nullptr; /**< The entries, in storage or in the mapping */
+    unique_ptr<MappedFile> mapping; /**< The cache file the entries are read from, if any */
+};
+
+
+#endif //DA___2ND_PROJECT_DISTANCEMATRIX_H
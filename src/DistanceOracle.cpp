@@ -0,0 +1,197 @@
+//
+// Created by oem on 06/06/23.
+//
+
+#include "DistanceOracle.h"
+#include <cmath>
+
+/**
+ * @brief Constructs an oracle with no vertices.
+ */
+
+DistanceOracle::DistanceOracle() = default;
+
+/**
+ * @brief Constructs an oracle over a loaded graph. The graph must outlive the oracle.
+ *
+ * Coordinates are converted to points on the unit sphere once, so each lazy query costs a few multiplications, a
+ * square root and an asin.
+ *
+ * @param graph The graph, with or without a distance matrix.
+ */
+
+DistanceOracle::DistanceOracle(const Graph &graph) :
+    graph(&graph),
+    matrix(graph.getDistMatrix()),
+    size(graph.getNumVertex())
+    {
+    if (matrix == nullptr && graph.hasCoordinates()) {
+        x.resize(size);
+        y.resize(size);
+        z.resize(size);
+        for (int i = 0; i < size; i++) {
+            double point[3];
+            toUnitSphere(graph.vertexAt(i)->getLatitude(), graph.vertexAt(i)->getLongitude(), point);
+            x[i] = point[0];
+            y[i] = point[1];
+            z[i] = point[2];
+        }
+    }
+}
+
+/**
+ * @brief Checks if a graph should get a dense distance matrix.
+ *
+ * @param graph The loaded graph.
+ * @return False for graphs with coordinates whose matrix would exceed MAX_MATRIX_BYTES, true otherwise.
+ */
+
+bool DistanceOracle::wantsMatrix(const Graph &graph) {
+    size_t n = graph.getNumVertex();
+    size_t bytes = n * (n - 1) / 2 * DistanceMatrix::bytesPerEntry(DistanceMatrix::defaultPrecision());
+    return !graph.hasCoordinates() || n < 2 || bytes <= MAX_MATRIX_BYTES;
+}
+
+/**
+ * @brief Computes the great-circle distance between two points.
+ *
+ * @param lat1 The latitude of the first point, in degrees.
+ * @param lon1 The longitude of the first point, in degrees.
+ * @param lat2 The latitude of the second point, in degrees.
+ * @param lon2 The longitude of the second point, in degrees.
+ * @return The distance in meters.
+ */
+
+double DistanceOracle::haversine(double lat1, double lon1, double lat2, double lon2) {
+    double phi1 = lat1 * M_PI / 180.0;
+    double phi2 = lat2 * M_PI / 180.0;
+    double dPhi = sin((phi2 - phi1) / 2);
+    double dLambda = sin((lon2 - lon1) * M_PI / 360.0);
+    double h = dPhi * dPhi + cos(phi1) * cos(phi2) * dLambda * dLambda;
+    return 2 * EARTH_RADIUS * asin(sqrt(min(1.0, h)));
+}
+
+/**
+ * @brief Converts coordinates to a point on the unit sphere.
+ *
+ * The straight-line distance between two such points grows with the great-circle distance between the coordinates,
+ * so nearest points on the sphere are nearest on the Earth.
+ *
+ * @param latitude The latitude, in degrees.
+ * @param longitude The longitude, in degrees.
+ * @param point Receives the x, y and z coordinates of the point.
+ */
+
+void DistanceOracle::toUnitSphere(double latitude, double longitude, double point[3]) {
+    double phi = latitude * M_PI / 180.0;
+    double lambda = longitude * M_PI / 180.0;
+    point[0] = cos(phi) * cos(lambda);
+    point[1] = cos(phi) * sin(lambda);
+    point[2] = sin(phi);
+}
+
+/**
+ * @brief Computes the haversine distance between two vertices from their positions on the unit sphere.
+ *
+ * The haversine of the central angle is a quarter of the squared chord between the two points.
+ *
+ * @param i The dense index of the first vertex.
+ * @param j The dense index of the second vertex, distinct from i.
+ * @return The distance in meters, at least CO_LOCATED_DISTANCE.
+ */
+
+double DistanceOracle::geo(int i, int j) const {
+    double dx = x[i] - x[j];
+    double dy = y[i] - y[j];
+    double dz = z[i] - z[j];
+    double h = (dx * dx + dy * dy + dz * dz) / 4;
+    return max(CO_LOCATED_DISTANCE, 2 * EARTH_RADIUS * asin(sqrt(min(1.0, h))));
+}
+
+/**
+ * @brief Computes a distance when there is no matrix.
+ *
+ * The edge is found through the graph's edge index when it was built, else by scanning the adjacency of i.
+ *
+ * @param i The dense index of the first vertex.
+ * @param j The dense index of the second vertex.
+ * @return The edge weight, else the haversine distance, else 0.
+ */
+
+double DistanceOracle::lazy(int i, int j) const {
+    if (i == j) {
+        return 0;
+    }
+    const EdgeIndex &index = graph->getEdgeIndex();
+    if (!index.empty()) {
+        double weight;
+        if (index.find(i, j, weight)) {
+            return weight;
+        }
+        return x.empty() ? 0 : geo(i, j);
+    }
+    NeighbourView edges = graph->getAdjacency().neighbours(i);
+    for (size_t k = 0; k < edges.size(); k++) {
+        if (edges.target(k) == j) {
+            return edges.weight(k);
+        }
+    }
+    return x.empty() ? 0 : geo(i, j);
+}
+
+/**
+ * @brief Fills the distances from one vertex to every vertex in O(n + degree).
+ *
+ * @param i The dense index of the vertex.
+ * @param out An array of getNumVertex() entries that receives the distances.
+ */
+
+void DistanceOracle::row(int i, double *out) const {
+    if (matrix != nullptr) {
+        for (int j = 0; j < size; j++) {
+            out[j] = (*matrix)(i, j);
+        }
+        return;
+    }
+    for (int j = 0; j < size; j++) {
+        out[j] = x.empty() || j == i ? 0 : geo(i, j);
+    }
+    // Walk the edges backwards so the first edge to each neighbour wins, as in lazy()
+    NeighbourView edges = graph->getAdjacency().neighbours(i);
+    for (size_t k = edges.size(); k-- > 0;) {
+        if (edges.target(k) != i) {
+            out[edges.target(k)] = edges.weight(k);
+        }
+    }
+}
+
+/**
+ * @brief Checks if every pair of vertices has a known distance.
+ *
+ * @return True if the graph has coordinates or the matrix is the metric closure of a connected graph, false if
+ * missing edges read as 0.
+ */
+
+bool DistanceOracle::isComplete() const {
+    return isGeometric() || (matrix != nullptr && (graph->hasCoordinates() || graph->hasMetricClosure()));
+}
+
+/**
+ * @brief Checks if distances between non-adjacent vertices are haversine distances.
+ *
+ * @return True if there is no matrix and the graph has coordinates, so a SpatialIndex finds the nearest vertices.
+ */
+
+bool DistanceOracle::isGeometric() const {
+    return matrix == nullptr && !x.empty();
+}
+
+/**
+ * @brief Returns the number of vertices.
+ *
+ * @return The number of vertices the oracle answers for.
+ */
+
+int DistanceOracle::getNumVertex() const {
+    return size;
+}
@@ -0,0 +1,174 @@
+//
+// Created by oem on 06/06/23.
+//
+
+#ifndef DA___2ND_PROJECT_DISTANCEORACLE_H
+#define DA___2ND_PROJECT_DISTANCEORACLE_H
+
+#include <vector>
+#include "Graph.h"
+
+using namespace std;
+
+/**
+ * @brief The DistanceOracle class answers distance queries between vertices by dense index.
+ *
+ * If the graph has a distance matrix the oracle reads it, and a distance of 0 means the vertices are not adjacent.
+ * Otherwise distances are computed on demand: the weight of the edge between the vertices if there is one, or the
+ * haversine distance between their coordinates if the graph was loaded with a nodes file. In that case every pair
+ * has a distance, so the algorithms can treat the graph as complete without ever materialising the matrix. The
+ * matrix of a smaller graph with coordinates is filled by the same rule, so both give the same distances.
+ */
+
+class DistanceOracle {
+public:
+
+/**
+ * The most memory the distance matrix of a graph with coordinates may take; larger graphs get no matrix.
+ */
+
+    static constexpr size_t MAX_MATRIX_BYTES = (size_t) 64 << 20;
+
+/**
+ * Mean radius of the Earth in meters, the unit of the datasets' haversine distances.
+ */
+
+    static constexpr double EARTH_RADIUS = 6371000.0;
+
+/**
+ * The haversine distance given to distinct vertices at the same coordinates, in meters, since 0 reads as "not
+ * adjacent".
+ */
+
+    static constexpr double CO_LOCATED_DISTANCE = 1e-6;
+
+/**
+ * @brief Constructs an oracle with no vertices.
+ */
+
+    DistanceOracle();
+
+/**
+ * @brief Constructs an oracle over a loaded graph. The graph must outlive the oracle.
+ *
+ * @param graph The graph, with or without a distance matrix.
+ */
+
+    explicit DistanceOracle(const Graph &graph);
+
+/**
+ * @brief Checks if a graph should get a dense distance matrix.
+ *
+ * @param graph The loaded graph.
+ * @return False for graphs with coordinates whose matrix would exceed MAX_MATRIX_BYTES, true otherwise.
+ */
+
+    static bool wantsMatrix(const Graph &graph);
+
+/**
+ * @brief Computes the great-circle distance between two points.
+ *
+ * @param lat1 The latitude of the first point, in degrees.
+ * @param lon1 The longitude of the first point, in degrees.
+ * @param lat2 The latitude of the second point, in degrees.
+ * @param lon2 The longitude of the second point, in degrees.
+ * @return The distance in meters.
+ */
+
+    static double haversine(double lat1, double lon1, double lat2, double lon2);
+
+/**
+ * @brief Converts coordinates to a point on the unit sphere.
+ *
+ * The straight-line distance between two such points grows with the great-circle distance between the coordinates,
+ * so nearest points on the sphere are nearest on the Earth.
+ *
+ * @param latitude The latitude, in degrees.
+ * @param longitude The longitude, in degrees.
+ * @param point Receives the x, y and z coordinates of the point.
+ */
+
+    static void toUnitSphere(double latitude, double longitude, double point[3]);
+
+/**
+ * @brief Returns the distance between two vertices.
+ *
+ * @param i The dense index of the first vertex.
+ * @param j The dense index of the second vertex.
+ * @return The distance, or 0 if it is unknown.
+ */
+
+    double operator()(int i, int j) const {
+        if (matrix != nullptr) {
+            return (*matrix)(i, j);
+        }
+        return lazy(i, j);
+    }
+
+/**
+ * @brief Fills the distances from one vertex to every vertex in O(n + degree).
+ *
+ * @param i The dense index of the vertex.
+ * @param out An array of getNumVertex() entries that receives the distances.
+ */
+
+    void row(int i, double *out) const;
+
+/**
+ * @brief Checks if every pair of vertices has a known distance.
+ *
+ * @return True if the graph has coordinates or the matrix is the metric closure of a connected graph, false if
+ * missing edges read as 0.
+ */
+
+    bool isComplete() const;
+
+/**
+ * @brief Checks if distances between non-adjacent vertices are haversine distances.
+ *
+ * @return True if there is no matrix and the graph has coordinates, so a SpatialIndex finds the nearest vertices.
+ */
+
+    bool isGeometric() const;
+
+/**
+ * @brief Returns the number of vertices.
+ *
+ * @return The number of vertices the oracle answers for.
+ */
+
+    int getNumVertex() const;
+
+private:
+    const Graph *graph = nullptr; /**< The graph whose edges are looked up */
+    const DistanceMatrix *matrix = nullptr; /**< The graph's distance matrix, or nullptr to compute distances lazily */
+    int size = 0; /**< Number of vertices */
+    vector<double> x; /**< Position of each vertex on the unit sphere, empty without coordinates */
+    vector<double> y; /**< Position of each vertex on the unit sphere */
+    vector<double> z; /**< Position of each vertex on the unit sphere */
+
+/**
+ * @brief Computes a distance when there is no matrix.
+ *
+ * The edge is found through the graph's edge index when it was built, else by scanning the adjacency of i.
+ *
+ * @param i The dense index of the first vertex.
+ * @param j The dense index of the second vertex.
+ * @return The edge weight, else the haversine distance, else 0.
+ */
+
+    double lazy(int i, int j) const;
+
+/**
+ * @brief Computes the haversine distance between two vertices from their positions on the unit sphere.
+ *
+ * @param i The dense index of the first vertex.
+ * @param j The dense index of the second vertex, distinct from i.
+ * @return The distance in meters, at least CO_LOCATED_DISTANCE.
+ */
+
+    double geo(int i, int j) const;
+};
+
+
+#endif //DA___2ND_PROJECT_DISTANCEORACLE_H
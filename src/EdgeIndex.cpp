@@ -0,0 +1,81 @@
+//
+// Created by oem on 11/06/23.
+//
+
+#include "EdgeIndex.h"
+
+/**
+ * @brief Indexes every edge of an adjacency. When a pair of vertices has several edges, the first one is kept.
+ *
+ * The table gets at least twice as many slots as there are undirected edges, so probe sequences stay short.
+ * Vertices are visited in index order and each pair is inserted from its smaller end, where the first edge matches
+ * the one a scan of the adjacency would find.
+ *
+ * @param adjacency The adjacency, with every edge stored in both directions.
+ */
+
+void EdgeIndex::build(const CompactGraph &adjacency) {
+    size_t pairs = adjacency.getNumEdges() / 2 + 1;
+    size_t slots = 1;
+    int bits = 0;
+    while (slots < 2 * pairs) {
+        slots <<= 1;
+        bits++;
+    }
+    keys.assign(slots, EMPTY);
+    weights.assign(slots, 0.0);
+    mask = slots - 1;
+    shift = 64 - bits;
+    count = 0;
+
+    int n = adjacency.getNumVertex();
+    for (int u = 0; u < n; u++) {
+        NeighbourView edges = adjacency.neighbours(u);
+        for (size_t k = 0; k < edges.size(); k++) {
+            int v = edges.target(k);
+            if (v <= u) {
+                continue;
+            }
+            uint64_t key = pack(u, v);
+            size_t slot = slotOf(key);
+            while (keys[slot] != EMPTY && keys[slot] != key) {
+                slot = (slot + 1) & mask;
+            }
+            if (keys[slot] == EMPTY) {
+                keys[slot] = key;
+                weights[slot] = edges.weight(k);
+                count++;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Checks if the index holds any edge.
+ *
+ * @return True if it was not built or the graph has no edges, false otherwise.
+ */
+
+bool EdgeIndex::empty() const {
+    return count == 0;
+}
+
+/**
+ * @brief Returns the number of indexed vertex pairs.
+ *
+ * @return The number of distinct undirected edges.
+ */
+
+size_t EdgeIndex::size() const {
+    return count;
+}
+
+/**
+ * @brief Returns the memory held by the table.
+ *
+ * @return The number of bytes.
+ */
+
+size_t EdgeIndex::memoryUsage() const {
+    return keys.size() * (sizeof(uint64_t) + sizeof(double));
+}
@@ -0,0 +1,120 @@
+//
+// Created by oem on 11/06/23.
+//
+
+#ifndef DA___2ND_PROJECT_EDGEINDEX_H
+#define DA___2ND_PROJECT_EDGEINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "CompactGraph.h"
+
+using namespace std;
+
+/**
+ * @brief The EdgeIndex class finds the weight of the edge between two vertices in constant expected time.
+ *
+ * It is an open-addressing hash table with linear probing, keyed by the pair of dense indices packed as
+ * (min << 32 | max), so both directions of an undirected edge share one slot. Keys and weights live in two flat
+ * arrays, taking 16 bytes per slot and at most 2 slots per undirected edge, far less than a distance matrix on
+ * sparse graphs.
+ */
+
+class EdgeIndex {
+public:
+
+/**
+ * @brief Indexes every edge of an adjacency. When a pair of vertices has several edges, the first one is kept.
+ *
+ * @param adjacency The adjacency, with every edge stored in both directions.
+ */
+
+    void build(const CompactGraph &adjacency);
+
+/**
+ * @brief Finds the weight of the edge between two vertices.
+ *
+ * @param u The dense index of one vertex.
+ * @param v The dense index of the other vertex.
+ * @param weight Receives the weight of the edge, if there is one.
+ * @return True if the vertices are adjacent, false otherwise.
+ */
+
+    bool find(int u, int v, double &weight) const {
+        if (keys.empty()) {
+            return false;
+        }
+        uint64_t key = pack(u, v);
+        for (size_t slot = slotOf(key);; slot = (slot + 1) & mask) {
+            if (keys[slot] == key) {
+                weight = weights[slot];
+                return true;
+            }
+            if (keys[slot] == EMPTY) {
+                return false;
+            }
+        }
+    }
+
+/**
+ * @brief Checks if the index holds any edge.
+ *
+ * @return True if it was not built or the graph has no edges, false otherwise.
+ */
+
+    bool empty() const;
+
+/**
+ * @brief Returns the number of indexed vertex pairs.
+ *
+ * @return The number of distinct undirected edges.
+ */
+
+    size_t size() const;
+
+/**
+ * @brief Returns the memory held by the table.
+ *
+ * @return The number of bytes.
+ */
+
+    size_t memoryUsage() const;
+
+private:
+    static constexpr uint64_t EMPTY = UINT64_MAX; /**< Key of a free slot, never a valid pair */
+
+    vector<uint64_t> keys; /**< The packed pair of each slot, or EMPTY */
+    vector<double> weights; /**< The weight of each slot */
+    size_t mask = 0; /**< Number of slots minus 1, the number of slots being a power of 2 */
+    int shift = 64; /**< 64 minus the number of bits of a slot */
+    size_t count = 0; /**< Number of used slots */
+
+/**
+ * @brief Packs an unordered pair of vertices into a key.
+ *
+ * @param u The dense index of one vertex.
+ * @param v The dense index of the other vertex.
+ * @return The smaller index in the high half and the larger in the low half.
+ */
+
+    static uint64_t pack(int u, int v) {
+        uint32_t a = (uint32_t) u;
+        uint32_t b = (uint32_t) v;
+        return a < b ? (uint64_t) a << 32 | b : (uint64_t) b << 32 | a;
+    }
+
+/**
+ * @brief Returns the first slot probed for a key, by Fibonacci hashing.
+ *
+ * @param key The packed pair.
+ * @return The home slot of the key.
+ */
+
+    size_t slotOf(uint64_t key) const {
+        return (size_t) ((key * 0x9E3779B97F4A7C15ull) >> shift);
+    }
+};
+
+
+#endif //DA___2ND_PROJECT_EDGEINDEX_H
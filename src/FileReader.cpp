@@ -3,6 +3,8 @@
 //
 
 #include "FileReader.h"
+#include <charconv>
+#include <cstring>
 
 
 /**
@@ -21,7 +23,7 @@ bool FileReader::readEdges1(Graph& graph, const fs::path& file_name ) {
         cout << "File not created!" << endl;
         return false;
     }else{
-        cout << "file accepted" << endl;
+        LOG(Logger::INFO, "file accepted");
 
         string file_line;
 
@@ -102,7 +104,7 @@ bool FileReader::readNodes(Graph& graph, const fs::path& file_name) {
         cout << "File not created!" << endl;
         return false;
     } else {
-        cout << "file accepted" << endl;
+        LOG(Logger::INFO, "file accepted");
 
         string file_line;
 
@@ -139,7 +141,7 @@ bool FileReader::readNodes(Graph& graph, const fs::path& file_name) {
                         break;
                 }
             }
-            cout << "Nodes : " << stoi(id) << " - " << stod(longitude) << " - " << stod(latitude) << endl;
+            LOG(Logger::DEBUG, "Nodes : " << id << " - " << longitude << " - " << latitude);
 
             graph.addVertex(stoi(id), stod(longitude), stod(latitude));
         }
@@ -204,7 +206,7 @@ bool FileReader::readEdges2(Graph& graph, const fs::path& file_name){
                         break;
                 }
             }
-            cout << "Edges : " << stoi(A) << " - " << stoi(B) << " - " << stod(dis) << endl;
+            LOG(Logger::DEBUG, "Edges : " << A << " - " << B << " - " << dis);
             graph.addBidirectionalEdge(stoi(A),stoi(B),stod(dis));
         }
         file.close();
@@ -212,13 +214,466 @@ bool FileReader::readEdges2(Graph& graph, const fs::path& file_name){
     }
 }
 
+/**
+ * Splits a CSV line in place, trimming blanks and carriage returns around each field.
+ *
+ * @param begin The first character of the line.
+ * @param end One past the last character of the line.
+ * @param fields The array that receives the fields.
+ * @param maxFields The capacity of the fields array.
+ * @return The number of fields in the line, which may be larger than maxFields.
+ */
+
+int FileReader::splitLine(const char *begin, const char *end, string_view fields[], int maxFields) {
+    int count = 0;
+    const char *p = begin;
+    while (true) {
+        auto comma = static_cast<const char *>(memchr(p, ',', end - p));
+        const char *fieldEnd = comma == nullptr ? end : comma;
+        const char *first = p;
+        while (first < fieldEnd && (*first == ' ' || *first == '\t')) first++;
+        const char *last = fieldEnd;
+        while (last > first && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r')) last--;
+        if (count < maxFields) {
+            fields[count] = string_view(first, last - first);
+        }
+        count++;
+        if (comma == nullptr) {
+            return count;
+        }
+        p = comma + 1;
+    }
+}
+
+/**
+ * Parses an integer field without allocating.
+ *
+ * @param field The field to parse.
+ * @param value The parsed value.
+ * @return True if the whole field is a valid integer, false otherwise.
+ */
+
+bool FileReader::toInt(string_view field, int &value) {
+    auto res = from_chars(field.data(), field.data() + field.size(), value);
+    return res.ec == errc() && res.ptr == field.data() + field.size() && !field.empty();
+}
+
+/**
+ * Parses a floating point field without allocating.
+ *
+ * @param field The field to parse.
+ * @param value The parsed value.
+ * @return True if the whole field is a valid number, false otherwise.
+ */
+
+bool FileReader::toDouble(string_view field, double &value) {
+    auto res = from_chars(field.data(), field.data() + field.size(), value);
+    return res.ec == errc() && res.ptr == field.data() + field.size() && !field.empty();
+}
+
+/**
+ * Calls a function for every line of a buffer with the line split into fields.
+ *
+ * @param begin The first character of the first line.
+ * @param end One past the last character of the buffer.
+ * @param onRow Called as onRow(fields, count) with at most MAX_FIELDS fields filled in.
+ */
+
+template <class F>
+void FileReader::forEachRow(const char *begin, const char *end, F onRow) {
+    string_view fields[MAX_FIELDS];
+    for (const char *p = begin; p < end;) {
+        auto eol = static_cast<const char *>(memchr(p, '\n', end - p));
+        if (eol == nullptr) {
+            eol = end;
+        }
+        onRow(fields, splitLine(p, eol, fields, MAX_FIELDS));
+        p = eol + 1;
+    }
+}
+
+/**
+ * Reads edge data from a memory mapped CSV file, parsing every field in place.
+ *
+ * The file is streamed twice: the first pass creates the vertices (when no nodes file was read) and counts the
+ * degree of every vertex, and the second writes the edges straight into the graph's adjacency. A vertex name is
+ * only copied out of the mapping when its vertex is new.
+ *
+ * @param graph The graph object to add the edges to.
+ * @param file_name The path to the CSV file.
+ * @return True if the file was successfully mapped and edges were added, false otherwise.
+ */
+
+bool FileReader::readEdgesMapped(Graph& graph, const fs::path& file_name) {
+    auto startTime = chrono::steady_clock::now();
+    MappedFile file(file_name);
+
+    if (!file.isOpen()) {
+        cout << "File not created!" << endl;
+        return false;
+    }
+
+    const char *end = file.data() + file.size();
+    const char *rows = skipLine(file.data(), end);
+
+    forEachRow(rows, end, [&](const string_view fields[], int count) {
+        int A, B;
+        double dis;
+        if (count < 3 || !toInt(fields[0], A) || !toInt(fields[1], B) || !toDouble(fields[2], dis)) {
+            return;
+        }
+        if (!nodes) {
+            if (count > 3) {
+                if (graph.findVertex(A) == nullptr) graph.addVertex(A, string(fields[3]));
+                if (graph.findVertex(B) == nullptr) graph.addVertex(B, count > 4 ? string(fields[4]) : string());
+            }
+            else {
+                graph.addVertex(A);
+                graph.addVertex(B);
+            }
+        }
+        graph.countEdge(A, B);
+    });
+
+    graph.allocateEdges();
+
+    forEachRow(rows, end, [&](const string_view fields[], int count) {
+        int A, B;
+        double dis;
+        if (count >= 3 && toInt(fields[0], A) && toInt(fields[1], B) && toDouble(fields[2], dis)
+            && graph.placeEdge(A, B, dis)) {
+            stats.rows++;
+        }
+    });
+
+    stats.bytes += file.size();
+    stats.seconds += chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    return true;
+}
+
+/**
+ * Skips the line starting at the given position.
+ *
+ * @param p The first character of the line.
+ * @param end One past the last character of the buffer.
+ * @return The first character of the next line, or end.
+ */
+
+const char * FileReader::skipLine(const char *p, const char *end) {
+    auto eol = static_cast<const char *>(memchr(p, '\n', end - p));
+    return eol == nullptr ? end : eol + 1;
+}
+
+/**
+ * Splits a buffer of CSV rows into chunks that start and end on line boundaries.
+ *
+ * @param begin The first character of the first row.
+ * @param end One past the last character of the buffer.
+ * @param count The number of chunks.
+ * @return The count + 1 chunk boundaries; chunk i spans [bounds[i], bounds[i + 1]).
+ */
+
+vector<const char *> FileReader::splitChunks(const char *begin, const char *end, unsigned count) {
+    vector<const char *> bounds(count + 1, end);
+    bounds[0] = begin;
+    size_t step = (end - begin) / count;
+    for (unsigned i = 1; i < count; i++) {
+        const char *guess = max(bounds[i - 1], begin + step * i);
+        bounds[i] = guess == begin ? begin : skipLine(guess - 1, end);
+    }
+    return bounds;
+}
+
+/**
+ * Parses the node rows in a chunk of a nodes file, skipping malformed rows.
+ *
+ * @param begin The first character of the chunk.
+ * @param end One past the last character of the chunk.
+ * @param out The vector that receives the parsed rows.
+ */
+
+void FileReader::parseNodes(const char *begin, const char *end, vector<NodeRecord> &out) {
+    out.reserve((end - begin) / 24);
+    forEachRow(begin, end, [&](const string_view fields[], int count) {
+        NodeRecord node;
+        if (count >= 3 && toInt(fields[0], node.id)
+            && toDouble(fields[1], node.longitude) && toDouble(fields[2], node.latitude)) {
+            out.push_back(node);
+        }
+    });
+}
+
+/**
+ * Parses the edge rows in a chunk of an edges file, skipping malformed rows.
+ *
+ * @param begin The first character of the chunk.
+ * @param end One past the last character of the chunk.
+ * @param out The vector that receives the parsed rows.
+ */
+
+void FileReader::parseEdges(const char *begin, const char *end, vector<EdgeRecord> &out) {
+    out.reserve((end - begin) / 16);
+    forEachRow(begin, end, [&](const string_view fields[], int count) {
+        EdgeRecord edge;
+        if (count >= 3 && toInt(fields[0], edge.orig)
+            && toInt(fields[1], edge.dest) && toDouble(fields[2], edge.weight)) {
+            out.push_back(edge);
+        }
+    });
+}
+
+/**
+ * Reads a nodes file and an edges file at the same time, splitting both into chunks parsed on worker threads.
+ *
+ * The workers are shared between the two files in proportion to their sizes. Each worker fills its own buffer;
+ * the buffers are then merged into the graph in file order in one bulk step, vertices first.
+ *
+ * @param graph The graph object to fill.
+ * @param nodes_file The path to the nodes CSV file.
+ * @param edges_file The path to the edges CSV file.
+ * @return True if both files were mapped and read, false otherwise.
+ */
+
+bool FileReader::readParallel(Graph& graph, const fs::path& nodes_file, const fs::path& edges_file) {
+    auto startTime = chrono::steady_clock::now();
+    MappedFile nodesFile(nodes_file);
+    MappedFile edgesFile(edges_file);
+
+    if (!nodesFile.isOpen() || !edgesFile.isOpen()) {
+        cout << "File not created!" << endl;
+        return false;
+    }
+
+    unsigned workers = max(2u, threads);
+    size_t total = max<size_t>(nodesFile.size() + edgesFile.size(), 1);
+    auto nodeWorkers = (unsigned) clamp<size_t>(workers * nodesFile.size() / total, 1, workers - 1);
+    unsigned edgeWorkers = workers - nodeWorkers;
+
+    const char *nodesEnd = nodesFile.data() + nodesFile.size();
+    const char *edgesEnd = edgesFile.data() + edgesFile.size();
+    vector<const char *> nodeBounds = splitChunks(skipLine(nodesFile.data(), nodesEnd), nodesEnd, nodeWorkers);
+    vector<const char *> edgeBounds = splitChunks(skipLine(edgesFile.data(), edgesEnd), edgesEnd, edgeWorkers);
+
+    vector<vector<NodeRecord>> nodeBatches(nodeWorkers);
+    vector<vector<EdgeRecord>> edgeBatches(edgeWorkers);
+    vector<thread> pool;
+    for (unsigned i = 0; i < nodeWorkers; i++) {
+        pool.emplace_back(parseNodes, nodeBounds[i], nodeBounds[i + 1], ref(nodeBatches[i]));
+    }
+    for (unsigned i = 0; i < edgeWorkers; i++) {
+        pool.emplace_back(parseEdges, edgeBounds[i], edgeBounds[i + 1], ref(edgeBatches[i]));
+    }
+    for (auto &worker : pool) {
+        worker.join();
+    }
+
+    graph.addVertices(nodeBatches);
+    graph.addBidirectionalEdges(edgeBatches);
+
+    for (const auto &batch : nodeBatches) stats.rows += batch.size();
+    for (const auto &batch : edgeBatches) stats.rows += batch.size();
+    stats.bytes += nodesFile.size() + edgesFile.size();
+    stats.seconds += chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    return true;
+}
+
+/**
+ * Calls a function for every data row of a file, reading it through a CompressedStream.
+ *
+ * Rows are parsed block by block while the decoder thread produces the next blocks; a row split between two blocks
+ * is carried over. The header line is skipped.
+ *
+ * @param file_name The path to the file, compressed or not.
+ * @param onRow Called as onRow(fields, count) with at most MAX_FIELDS fields filled in.
+ * @param bytes Incremented by the number of decompressed bytes.
+ * @return True if the whole file was read, false otherwise.
+ */
+
+template <class F>
+bool FileReader::forEachStreamedRow(const fs::path& file_name, F onRow, size_t &bytes) {
+    CompressedStream stream(file_name);
+    if (!stream.isOpen()) {
+        if (!CompressedStream::isSupported(CompressedStream::codecOf(file_name))) {
+            cout << "Compressed input " << file_name.filename() << " is not supported by this build!" << endl;
+        } else {
+            cout << "File not created!" << endl;
+        }
+        return false;
+    }
+
+    vector<char> block;
+    string carry;
+    bool header = true;
+    while (stream.next(block)) {
+        bytes += block.size();
+        const char *p = block.data();
+        const char *end = p + block.size();
+        if (header || !carry.empty()) {
+            // Complete the row (or header) that started in an earlier block
+            auto eol = static_cast<const char *>(memchr(p, '\n', end - p));
+            if (eol == nullptr) {
+                carry.append(p, end);
+                continue;
+            }
+            carry.append(p, eol + 1);
+            if (!header) {
+                forEachRow(carry.data(), carry.data() + carry.size(), onRow);
+            }
+            header = false;
+            carry.clear();
+            p = eol + 1;
+        }
+        auto last = static_cast<const char *>(memrchr(p, '\n', end - p));
+        if (last == nullptr) {
+            carry.assign(p, end);
+            continue;
+        }
+        forEachRow(p, last + 1, onRow);
+        carry.assign(last + 1, end);
+    }
+    if (!header && !carry.empty()) {
+        forEachRow(carry.data(), carry.data() + carry.size(), onRow);
+    }
+    if (stream.failed()) {
+        cout << "Could not decode " << file_name.filename() << "!" << endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Reads the nodes (if available) and edges of a dataset whose files may be compressed (.csv.gz, .csv.zst).
+ *
+ * Each file is decompressed on its own thread while the rows already decompressed are parsed, so nothing is staged
+ * on disk and decoding overlaps parsing. Works for both the toy graphs and the large graphs.
+ *
+ * @param graph The graph object to fill.
+ * @param nodes_file The path to the nodes file, ignored when no nodes data is available.
+ * @param edges_file The path to the edges file.
+ * @return True if every file was decoded and read, false otherwise.
+ */
+
+bool FileReader::readCompressed(Graph& graph, const fs::path& nodes_file, const fs::path& edges_file) {
+    auto startTime = chrono::steady_clock::now();
+
+    if (nodes) {
+        vector<vector<NodeRecord>> batches(1);
+        bool ok = forEachStreamedRow(nodes_file, [&](const string_view fields[], int count) {
+            NodeRecord node;
+            if (count >= 3 && toInt(fields[0], node.id)
+                && toDouble(fields[1], node.longitude) && toDouble(fields[2], node.latitude)) {
+                batches[0].push_back(node);
+            }
+        }, stats.bytes);
+        if (!ok) {
+            return false;
+        }
+        graph.addVertices(batches);
+        stats.rows += batches[0].size();
+    }
+
+    bool ok = forEachStreamedRow(edges_file, [&](const string_view fields[], int count) {
+        int A, B;
+        double dis;
+        if (count < 3 || !toInt(fields[0], A) || !toInt(fields[1], B) || !toDouble(fields[2], dis)) {
+            return;
+        }
+        if (!nodes) {
+            if (count > 3) {
+                if (graph.findVertex(A) == nullptr) graph.addVertex(A, string(fields[3]));
+                if (graph.findVertex(B) == nullptr) graph.addVertex(B, count > 4 ? string(fields[4]) : string());
+            }
+            else {
+                graph.addVertex(A);
+                graph.addVertex(B);
+            }
+        }
+        if (graph.addBidirectionalEdge(A, B, dis)) {
+            stats.rows++;
+        }
+    }, stats.bytes);
+
+    stats.seconds += chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    return ok;
+}
+
+/**
+ * Reads the nodes (if available) and edges of a dataset with the configured loader, then builds the adjacency.
+ *
+ * Compressed files are always streamed through readCompressed().
+ *
+ * @param graph The graph object to fill.
+ * @param nodes_file The path to the nodes CSV file, ignored when no nodes data is available.
+ * @param edges_file The path to the edges CSV file.
+ * @return True if every file was read, false otherwise.
+ */
+
+bool FileReader::read(Graph& graph, const fs::path& nodes_file, const fs::path& edges_file) {
+    bool ok;
+    bool compressed = CompressedStream::codecOf(edges_file) != CompressedStream::PLAIN
+                      || (nodes && CompressedStream::codecOf(nodes_file) != CompressedStream::PLAIN);
+    if (compressed) {
+        ok = readCompressed(graph, nodes_file, edges_file);
+    }
+    else if (mapped && nodes) {
+        ok = readParallel(graph, nodes_file, edges_file);
+    }
+    else if (mapped) {
+        ok = readEdgesMapped(graph, edges_file);
+    }
+    else if (nodes) {
+        ok = readNodes(graph, nodes_file) && readEdges2(graph, edges_file);
+    }
+    else {
+        ok = readEdges1(graph, edges_file);
+    }
+    graph.buildAdjacency();
+    return ok;
+}
+
+/**
+ * Gets the accumulated throughput of the loaders.
+ *
+ * @return The load statistics.
+ */
+
+const LoadStats& FileReader::getStats() const {
+    return stats;
+}
+
+/**
+ * Gets the parsing rate in rows.
+ *
+ * @return The number of rows parsed per second.
+ */
+
+double LoadStats::rowsPerSecond() const {
+    return seconds > 0 ? rows / seconds : 0.0;
+}
+
+/**
+ * Gets the parsing rate in bytes.
+ *
+ * @return The number of megabytes (10^6 bytes) read per second.
+ */
+
+double LoadStats::megabytesPerSecond() const {
+    return seconds > 0 ? bytes / seconds / 1e6 : 0.0;
+}
+
 /**
  * Constructs a FileReader object.
  *
  * @param verify A boolean value indicating whether nodes data is available.
+ * @param mapped A boolean value indicating whether files are memory mapped instead of read line by line.
+ * @param threads The number of worker threads for the parallel loader, 0 to use every hardware thread.
  */
 
-FileReader::FileReader(bool verify) : nodes(verify) {}
+FileReader::FileReader(bool verify, bool mapped, unsigned threads) :
+    nodes(verify),
+    mapped(mapped),
+    threads(threads != 0 ? threads : max(1u, thread::hardware_concurrency()))
+    {}
 
 /**
  * Checks if the FileReader has nodes data available.
@@ -229,3 +684,13 @@ FileReader::FileReader(bool verify) : nodes(verify) {}
 bool FileReader::verify() const {
     return this->nodes;
 }
+
+/**
+ * Checks if the FileReader uses the memory mapped loaders.
+ *
+ * @return True if files are memory mapped, false otherwise.
+ */
+
+bool FileReader::isMapped() const {
+    return this->mapped;
+}
@@ -7,11 +7,43 @@
 
 #include <fstream>
 #include <filesystem>
+#include <string_view>
+#include <chrono>
+#include <thread>
 #include "Graph.h"
+#include "Logger.h"
+#include "MappedFile.h"
+#include "CompressedStream.h"
 
 namespace fs = std::filesystem;
 using namespace std;
 
+/**
+ * @brief The LoadStats struct accumulates the throughput of the loaders.
+ */
+
+struct LoadStats {
+    size_t rows = 0; /**< Number of data rows parsed */
+    size_t bytes = 0; /**< Number of bytes read */
+    double seconds = 0.0; /**< Wall-clock time spent reading */
+
+/**
+ * Gets the parsing rate in rows.
+ *
+ * @return The number of rows parsed per second.
+ */
+
+    double rowsPerSecond() const;
+
+/**
+ * Gets the parsing rate in bytes.
+ *
+ * @return The number of megabytes (10^6 bytes) read per second.
+ */
+
+    double megabytesPerSecond() const;
+};
+
 /**
  * @brief The FileReader class handles reading data from files.
  */
@@ -19,15 +51,121 @@ using namespace std;
 class FileReader {
 private :
     bool nodes; /**< Indicates if the nodes file is present */
+    bool mapped; /**< Indicates if the files are read through memory mapping */
+    static const int MAX_FIELDS = 5; /**< The most fields used by any of the CSV formats */
+    unsigned threads; /**< Number of worker threads used by the parallel loader */
+    LoadStats stats; /**< Throughput of every file read so far */
+
+/**
+ * Skips the line starting at the given position.
+ *
+ * @param p The first character of the line.
+ * @param end One past the last character of the buffer.
+ * @return The first character of the next line, or end.
+ */
+
+    static const char * skipLine(const char *p, const char *end);
+
+/**
+ * Splits a buffer of CSV rows into chunks that start and end on line boundaries.
+ *
+ * @param begin The first character of the first row.
+ * @param end One past the last character of the buffer.
+ * @param count The number of chunks.
+ * @return The count + 1 chunk boundaries; chunk i spans [bounds[i], bounds[i + 1]).
+ */
+
+    static vector<const char *> splitChunks(const char *begin, const char *end, unsigned count);
+
+/**
+ * Parses the node rows in a chunk of a nodes file, skipping malformed rows.
+ *
+ * @param begin The first character of the chunk.
+ * @param end One past the last character of the chunk.
+ * @param out The vector that receives the parsed rows.
+ */
+
+    static void parseNodes(const char *begin, const char *end, vector<NodeRecord> &out);
+
+/**
+ * Parses the edge rows in a chunk of an edges file, skipping malformed rows.
+ *
+ * @param begin The first character of the chunk.
+ * @param end One past the last character of the chunk.
+ * @param out The vector that receives the parsed rows.
+ */
+
+    static void parseEdges(const char *begin, const char *end, vector<EdgeRecord> &out);
+
+/**
+ * Splits a CSV line in place, trimming blanks and carriage returns around each field.
+ *
+ * @param begin The first character of the line.
+ * @param end One past the last character of the line.
+ * @param fields The array that receives the fields.
+ * @param maxFields The capacity of the fields array.
+ * @return The number of fields in the line, which may be larger than maxFields.
+ */
+
+    static int splitLine(const char *begin, const char *end, string_view fields[], int maxFields);
+
+/**
+ * Calls a function for every line of a buffer with the line split into fields.
+ *
+ * @param begin The first character of the first line.
+ * @param end One past the last character of the buffer.
+ * @param onRow Called as onRow(fields, count) with at most MAX_FIELDS fields filled in.
+ */
+
+    template <class F>
+    static void forEachRow(const char *begin, const char *end, F onRow);
+
+/**
+ * Calls a function for every data row of a file, reading it through a CompressedStream.
+ *
+ * Rows are parsed block by block while the decoder thread produces the next blocks; a row split between two blocks
+ * is carried over. The header line is skipped.
+ *
+ * @param file_name The path to the file, compressed or not.
+ * @param onRow Called as onRow(fields, count) with at most MAX_FIELDS fields filled in.
+ * @param bytes Incremented by the number of decompressed bytes.
+ * @return True if the whole file was read, false otherwise.
+ */
+
+    template <class F>
+    static bool forEachStreamedRow(const fs::path& file_name, F onRow, size_t &bytes);
+
+/**
+ * Parses an integer field without allocating.
+ *
+ * @param field The field to parse.
+ * @param value The parsed value.
+ * @return True if the whole field is a valid integer, false otherwise.
+ */
+
+    static bool toInt(string_view field, int &value);
+
+/**
+ * Parses a floating point field without allocating.
+ *
+ * @param field The field to parse.
+ * @param value The parsed value.
+ * @return True if the whole field is a valid number, false otherwise.
+ */
+
+    static bool toDouble(string_view field, double &value);
+
 public :
 
 /**
  * Constructs a FileReader object.
  *
  * @param verify A boolean value indicating whether nodes data is available.
+ * @param mapped A boolean value indicating whether files are memory mapped instead of read line by line.
+ * @param threads The number of worker threads for the parallel loader, 0 to use every hardware thread.
  */
 
-    FileReader(bool verify);
+    FileReader(bool verify, bool mapped = true, unsigned threads = 0);
 
 /**
  * Reads edge data from a CSV file and adds edges to the graph (small and medium graphs).
@@ -59,6 +197,66 @@ public :
 
     bool readNodes(Graph& graph, const fs::path& file_name);
 
+/**
+ * Reads edge data from a memory mapped CSV file, parsing every field in place.
+ *
+ * Works for both the toy graphs (with optional vertex names) and the large graphs. The file is streamed twice:
+ * the first pass counts the degree of every vertex, and the second writes the edges straight into the graph's
+ * adjacency, so no memory is allocated per edge. The graph must not have any edges yet.
+ *
+ * @param graph The graph object to add the edges to.
+ * @param file_name The path to the CSV file.
+ * @return True if the file was successfully mapped and edges were added, false otherwise.
+ */
+
+    bool readEdgesMapped(Graph& graph, const fs::path& file_name);
+
+/**
+ * Reads a nodes file and an edges file at the same time, splitting both into chunks parsed on worker threads.
+ *
+ * Each worker fills its own buffer; the buffers are then merged into the graph in file order in one bulk step.
+ *
+ * @param graph The graph object to fill.
+ * @param nodes_file The path to the nodes CSV file.
+ * @param edges_file The path to the edges CSV file.
+ * @return True if both files were mapped and read, false otherwise.
+ */
+
+    bool readParallel(Graph& graph, const fs::path& nodes_file, const fs::path& edges_file);
+
+/**
+ * Reads the nodes (if available) and edges of a dataset whose files may be compressed (.csv.gz, .csv.zst).
+ *
+ * Each file is decompressed on its own thread while the rows already decompressed are parsed, so nothing is staged
+ * on disk and decoding overlaps parsing. Works for both the toy graphs and the large graphs.
+ *
+ * @param graph The graph object to fill.
+ * @param nodes_file The path to the nodes file, ignored when no nodes data is available.
+ * @param edges_file The path to the edges file.
+ * @return True if every file was decoded and read, false otherwise.
+ */
+
+    bool readCompressed(Graph& graph, const fs::path& nodes_file, const fs::path& edges_file);
+
+/**
+ * Reads the nodes (if available) and edges of a dataset with the configured loader, then builds the adjacency.
+ *
+ * @param graph The graph object to fill.
+ * @param nodes_file The path to the nodes CSV file, ignored when no nodes data is available.
+ * @param edges_file The path to the edges CSV file.
+ * @return True if every file was read, false otherwise.
+ */
+
+    bool read(Graph& graph, const fs::path& nodes_file, const fs::path& edges_file);
+
+/**
+ * Gets the accumulated throughput of the loaders.
+ *
+ * @return The load statistics.
+ */
+
+    const LoadStats& getStats() const;
+
 /**
  * Checks if the FileReader has nodes data available.
  *
@@ -66,6 +264,14 @@ public :
  */
 
     bool verify() const;
+
+/**
+ * Checks if the FileReader uses the memory mapped loaders.
+ *
+ * @return True if files are memory mapped, false otherwise.
+ */
+
+    bool isMapped() const;
 };
 
 
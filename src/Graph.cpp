@@ -3,6 +3,8 @@
 //
 
 #include "Graph.h"
+#include "DistanceOracle.h"
+#include "Parallel.h"
 
 /**
  * @brief Returns the number of vertices in the graph.
@@ -14,6 +16,16 @@ int Graph::getNumVertex() const {
     return vertexSet.size();
 }
 
+/**
+ * @brief Checks if the vertices were loaded with coordinates.
+ *
+ * @return True if the graph was read together with a nodes file, false otherwise.
+ */
+
+bool Graph::hasCoordinates() const {
+    return coordinates;
+}
+
 /**
  * @brief Returns a copy of the vertex set.
  *
@@ -48,7 +60,11 @@ Vertex * Graph::findVertex(const int &id) const {
 bool Graph::addVertex(const int &id) {
     if (findVertex(id) != nullptr)
         return false;
-    vertexSet.insert({id, new Vertex(id)});
+    auto v = vertexArena.create(id);
+    v->setIndex(adjacency.addVertex());
+    vertices.push_back(v);
+    ids.push_back(id);
+    vertexSet.insert({id, v});
     return true;
 }
 
@@ -63,7 +79,11 @@ bool Graph::addVertex(const int &id) {
 bool Graph::addVertex(const int &id, const string &name) {
     if (findVertex(id) != nullptr)
         return false;
-    vertexSet.insert({id, new Vertex(id, name)});
+    auto v = vertexArena.create(id, name);
+    v->setIndex(adjacency.addVertex());
+    vertices.push_back(v);
+    ids.push_back(id);
+    vertexSet.insert({id, v});
     return true;
 }
 
@@ -79,49 +99,323 @@ bool Graph::addVertex(const int &id, const string &name) {
 bool Graph::addVertex(const int &id, const double &longitude, const double &latitude) {
     if (findVertex(id) != nullptr)
         return false;
-    vertexSet.insert({id, new Vertex(id, longitude, latitude)});
+    auto v = vertexArena.create(id, longitude, latitude);
+    v->setIndex(adjacency.addVertex());
+    vertices.push_back(v);
+    ids.push_back(id);
+    vertexSet.insert({id, v});
+    coordinates = true;
     return true;
 }
 
 /**
  * @brief Adds a bidirectional edge between two vertices in the graph with the given weight.
  *
+ * The edge is queued and only becomes part of the adjacency when buildAdjacency() runs.
+ *
  * @param sourc The ID of the source vertex.
  * @param dest The ID of the destination vertex.
  * @param w The weight of the edge.
  * @return True if the edge is added successfully, false otherwise.
  */
 
-bool Graph::addBidirectionalEdge(const int &sourc, const int &dest, double w) const {
+bool Graph::addBidirectionalEdge(const int &sourc, const int &dest, double w) {
+    auto v1 = findVertex(sourc);
+    auto v2 = findVertex(dest);
+    if (v1 == nullptr || v2 == nullptr)
+        return false;
+    pending.push_back({v1->getIndex(), v2->getIndex(), w});
+    return true;
+}
+
+/**
+ * @brief Adds a batch of vertices with coordinates to the graph.
+ *
+ * Reserves room for the whole batch before inserting, so the vertex set is rehashed at most once and the vertices
+ * are laid out in a single chunk of the arena.
+ *
+ * @param batches The parsed rows, one vector per parsing thread, inserted in order.
+ * @return The number of vertices that were added.
+ */
+
+int Graph::addVertices(const vector<vector<NodeRecord>> &batches) {
+    size_t total = vertexSet.size();
+    for (const auto &batch : batches)
+        total += batch.size();
+    vertexSet.reserve(total);
+    vertexArena.reserve(total - vertexSet.size());
+
+    int added = 0;
+    for (const auto &batch : batches)
+        for (const auto &node : batch)
+            added += addVertex(node.id, node.longitude, node.latitude);
+    return added;
+}
+
+/**
+ * @brief Adds a batch of bidirectional edges to the graph.
+ *
+ * @param batches The parsed rows, one vector per parsing thread, inserted in order.
+ * @return The number of edges that were added.
+ */
+
+int Graph::addBidirectionalEdges(const vector<vector<EdgeRecord>> &batches) {
+    size_t total = pending.size();
+    for (const auto &batch : batches)
+        total += batch.size();
+    pending.reserve(total);
+
+    int added = 0;
+    for (const auto &batch : batches)
+        for (const auto &edge : batch)
+            added += addBidirectionalEdge(edge.orig, edge.dest, edge.weight);
+    return added;
+}
+
+/**
+ * @brief Counts a bidirectional edge in the first pass of a streaming load.
+ *
+ * @param sourc The ID of the source vertex.
+ * @param dest The ID of the destination vertex.
+ * @return True if both vertices exist, false otherwise.
+ */
+
+bool Graph::countEdge(const int &sourc, const int &dest) {
     auto v1 = findVertex(sourc);
     auto v2 = findVertex(dest);
     if (v1 == nullptr || v2 == nullptr)
         return false;
-    auto e1 = v1->addEdge(v2, w);
-    auto e2 = v2->addEdge(v1, w);
-    e1->setReverse(e2);
-    e2->setReverse(e1);
-
-   /*- if(sourc >= distMatrix.size() || dest >= distMatrix.size()){
-        int maxSize = std::max(sourc, dest) + 1;
-        distMatrix.resize(maxSize);
-        for (int i = 0; i < maxSize; i++) {
-            distMatrix[i].resize(maxSize);
+    adjacency.countEdge(v1->getIndex(), v2->getIndex());
+    return true;
+}
+
+/**
+ * @brief Allocates the adjacency for every edge counted by countEdge().
+ */
+
+void Graph::allocateEdges() {
+    adjacency.allocate();
+    built = true;
+}
+
+/**
+ * @brief Places a bidirectional edge in the second pass of a streaming load.
+ *
+ * @param sourc The ID of the source vertex.
+ * @param dest The ID of the destination vertex.
+ * @param w The weight of the edge.
+ * @return True if both vertices exist, false otherwise.
+ */
+
+bool Graph::placeEdge(const int &sourc, const int &dest, double w) {
+    auto v1 = findVertex(sourc);
+    auto v2 = findVertex(dest);
+    if (v1 == nullptr || v2 == nullptr)
+        return false;
+    adjacency.addEdge(v1->getIndex(), v2->getIndex(), w);
+    return true;
+}
+
+/**
+ * @brief Moves the queued edges into the adjacency, counting degrees first so it is allocated once.
+ *
+ * Does nothing if the adjacency was already built. Edges added after this call are ignored.
+ */
+
+void Graph::buildAdjacency() {
+    if (built)
+        return;
+    for (const auto &edge : pending)
+        adjacency.countEdge(edge.orig, edge.dest);
+    allocateEdges();
+    for (const auto &edge : pending)
+        adjacency.addEdge(edge.orig, edge.dest, edge.weight);
+    vector<EdgeRecord>().swap(pending);
+}
+
+/**
+ * @brief Replaces the adjacency with one built elsewhere, e.g. by a snapshot.
+ *
+ * @param compact The adjacency, indexed like the vertices of this graph.
+ */
+
+void Graph::setAdjacency(CompactGraph &&compact) {
+    adjacency = std::move(compact);
+    vector<EdgeRecord>().swap(pending);
+    built = true;
+}
+
+/**
+ * @brief Renumbers the dense indices of the vertices.
+ *
+ * The adjacency, or the queued edges, follow the new numbering, and the dataset IDs move with their vertices, so
+ * idOf() still translates results back. The distance matrix, next hops, edge index and candidate lists are indexed by
+ * the old numbering and are dropped; renumbering is meant to run right after loading, before any of them is built.
+ *
+ * @param order The old dense index of the vertex at every new dense index, a permutation of 0..n-1.
+ */
+
+void Graph::renumber(const vector<int> &order) {
+    int n = (int) order.size();
+    vector<int> position(n);
+    for (int i = 0; i < n; i++) {
+        position[order[i]] = i;
+    }
+
+    vector<Vertex *> oldVertices = std::move(vertices);
+    vector<int> oldIds = std::move(ids);
+    vertices.resize(n);
+    ids.resize(n);
+    for (int i = 0; i < n; i++) {
+        vertices[i] = oldVertices[order[i]];
+        ids[i] = oldIds[order[i]];
+        vertices[i]->setIndex(i);
+    }
+
+    if (built) {
+        vector<uint32_t> offsets(n + 1, 0);
+        vector<int> targets;
+        vector<double> weights;
+        targets.reserve(adjacency.getTargets().size());
+        weights.reserve(adjacency.getWeights().size());
+        for (int i = 0; i < n; i++) {
+            for (CompactEdge edge : adjacency.neighbours(order[i])) {
+                targets.push_back(position[edge.dest]);
+                weights.push_back(edge.weight);
+            }
+            offsets[i + 1] = (uint32_t) targets.size();
+        }
+        adjacency.assign(std::move(offsets), std::move(targets), std::move(weights));
+    }
+    else {
+        for (EdgeRecord &edge : pending) {
+            edge.orig = position[edge.orig];
+            edge.dest = position[edge.dest];
         }
     }
 
-    distMatrix[sourc][dest] = w;
-    distMatrix[dest][sourc] = w;-*/
-    return true;
+    delete distMatrix;
+    distMatrix = nullptr;
+    delete nextHops;
+    nextHops = nullptr;
+    closure = false;
+    edgeIndex = EdgeIndex();
+    candidates = CandidateSet();
+}
+
+/**
+ * @brief Returns the adjacency of the graph.
+ *
+ * @return The compact adjacency, indexed by Vertex::getIndex().
+ */
+
+const CompactGraph &Graph::getAdjacency() const {
+    return adjacency;
+}
+
+/**
+ * @brief Builds the hash index of the edge weights, for graphs that get no distance matrix.
+ *
+ * Builds the adjacency first if needed.
+ */
+
+void Graph::indexEdges() {
+    buildAdjacency();
+    edgeIndex.build(adjacency);
+}
+
+/**
+ * @brief Returns the hash index of the edge weights.
+ *
+ * @return The index, empty if indexEdges() was not called.
+ */
+
+const EdgeIndex &Graph::getEdgeIndex() const {
+    return edgeIndex;
+}
+
+/**
+ * @brief Returns the storage held by the vertices.
+ *
+ * @return The number of bytes allocated by the vertex arena, used or not.
+ */
+
+size_t Graph::vertexMemory() const {
+    return vertexArena.memoryUsage();
+}
+
+/**
+ * @brief Computes the candidate neighbour lists of every vertex, once the graph and its distances are loaded.
+ *
+ * @param k The most candidates per vertex.
+ * @param strategy How the candidates are chosen.
+ */
+
+void Graph::buildCandidates(int k, CandidateSet::Strategy strategy) {
+    buildAdjacency();
+    lock_guard<mutex> guard(candidatesLock);
+    candidates.build(*this, k, strategy);
+}
+
+/**
+ * @brief Returns the candidate neighbour lists, building them with the default parameters on first use.
+ *
+ * Loading a graph does not build them, since they take O(n^2 log n) on a metric closure and only some algorithms
+ * read them; renumber() drops them, so they are built again for the new indices. The first use is guarded by a lock,
+ * so several Services objects may ask for them on the same graph at once.
+ *
+ * @return The lists.
+ */
+
+const CandidateSet &Graph::getCandidates() const {
+    lock_guard<mutex> guard(candidatesLock);
+    if (candidates.empty()) {
+        candidates.build(*this);
+    }
+    return candidates;
+}
+
+/**
+ * @brief Translates a dataset ID into the dense index the algorithms work with.
+ *
+ * @param id The ID of the vertex.
+ * @return The dense index of the vertex, or -1 if there is no vertex with that ID.
+ */
+
+int Graph::indexOf(int id) const {
+    Vertex *v = findVertex(id);
+    return v == nullptr ? -1 : v->getIndex();
+}
+
+/**
+ * @brief Returns the dense index where every tour starts and ends.
+ *
+ * @return The index of the vertex with ID 0, or index 0 if there is no such vertex.
+ */
+
+int Graph::getStartIndex() const {
+    int start = indexOf(0);
+    return start == -1 ? 0 : start;
+}
+
+/**
+ * @brief Returns the vertex at a position of the adjacency.
+ *
+ * @param index The dense index of the vertex.
+ * @return Pointer to the vertex.
+ */
+
+Vertex *Graph::vertexAt(int index) const {
+    return vertices[index];
 }
 
 /**
  * @brief Returns the distance matrix of the graph.
  *
- * @return The distance matrix of the graph.
+ * @return The distance matrix of the graph, or nullptr if it was not built.
  */
 
-double ** Graph::getDistMatrix() const {
+const DistanceMatrix * Graph::getDistMatrix() const {
     return this->distMatrix;
 }
 
@@ -144,31 +438,172 @@ void Graph::setOptPathBT(int *path) {
 /**
  * @brief Sets the distance matrix of the graph.
  *
- * The distance matrix is a 2D array representing the distances between vertices in the graph.
- * Each element distMatrix[i][j] represents the distance between vertex i and vertex j.
+ * The distance matrix holds the distance between every pair of vertices, addressed by their dense indices, and 0
+ * for pairs that are not adjacent. Only its upper triangle is stored. Each row of the triangle is filled from the
+ * edges of one vertex, so the rows are filled in parallel.
+ *
+ * On graphs with coordinates, pairs that are not adjacent get their haversine distance instead of 0, the distance a
+ * DistanceOracle computes when the graph has no matrix, so a geo graph has the same distances whatever its size.
+ *
+ * @param precision The precision of the stored distances.
  */
 
-void Graph::setDistMatrix() {
-    distMatrix = new double * [vertexSet.size()];
-    for(int i=0; i<vertexSet.size(); i++){
-        distMatrix[i] = new double[vertexSet.size()];
-        for(int j = 0; j < vertexSet.size(); j++){
-            distMatrix[i][j] = 0.0;
+void Graph::setDistMatrix(DistanceMatrix::Precision precision) {
+    buildAdjacency();
+    int n = adjacency.getNumVertex();
+    size_t grain = max<size_t>(64, n / (8 * workerCount()));
+    if(coordinates){
+        delete distMatrix;
+        distMatrix = nullptr;
+        DistanceOracle oracle(*this);
+        // Only quantized entries need the largest distance before the first one is stored, and only they pay for
+        // computing every row twice
+        double maxDistance = 0;
+        if(precision == DistanceMatrix::QUANTIZED){
+            vector<double> rowMax(n, 0);
+            parallelFor(n, grain, [&](size_t begin, size_t end) {
+                vector<double> row(n);
+                for(int orig = (int) begin; orig < (int) end; orig++){
+                    oracle.row(orig, row.data());
+                    rowMax[orig] = *max_element(row.begin(), row.end());
+                }
+            });
+            maxDistance = n == 0 ? 0 : *max_element(rowMax.begin(), rowMax.end());
+        }
+        distMatrix = new DistanceMatrix(n, precision, maxDistance);
+        DistanceMatrix &matrix = *distMatrix;
+        parallelFor(n, grain, [&](size_t begin, size_t end) {
+            vector<double> row(n);
+            for(int orig = (int) begin; orig < (int) end; orig++){
+                oracle.row(orig, row.data());
+                size_t first = matrix.rowStart(orig);
+                for(int dest = orig + 1; dest < n; dest++){
+                    matrix.setEntry(first + (dest - orig - 1), row[dest]);
+                }
+            }
+        });
+        return;
+    }
+    double maxWeight = 0;
+    for(int orig = 0; orig < n; orig++){
+        for(CompactEdge t : adjacency.neighbours(orig)){
+            maxWeight = max(maxWeight, t.weight);
         }
     }
-    for(int i = 0; i < vertexSet.size(); i++){
-        for(auto t : vertexSet.at(i)->getAdj()){
-            int dest = t->getDest()->getId();
-            int orig = t->getOrig()->getId();
-
-            if(distMatrix[orig][dest] != 0){continue;}
-            distMatrix[orig][dest] = t->getWeight();
-            distMatrix[dest][orig] = t->getWeight();
+    delete distMatrix;
+    distMatrix = new DistanceMatrix(n, precision, maxWeight);
+    // Edges are stored in both directions, so row orig of the triangle only needs the edges to higher indices
+    DistanceMatrix &matrix = *distMatrix;
+    parallelFor(n, grain, [&](size_t begin, size_t end) {
+        for(int orig = (int) begin; orig < (int) end; orig++){
+            for(CompactEdge t : adjacency.neighbours(orig)){
+                int dest = t.dest;
+
+                if(dest <= orig || matrix(orig, dest) != 0){continue;}
+                matrix.setEntry(matrix.entryOf(orig, dest), t.weight);
+            }
         }
+    });
+}
+
+/**
+ * @brief Sets the distance matrix of the graph from a precomputed block.
+ *
+ * @param values The n(n-1)/2 distances of the upper triangle in row-major order, where n is the number of vertices.
+ * @param precision The precision of the stored distances.
+ */
 
+void Graph::setDistMatrix(const double *values, DistanceMatrix::Precision precision) {
+    int n = (int) vertexSet.size();
+    size_t entries = n < 2 ? 0 : (size_t) n * (n - 1) / 2;
+    double maxWeight = 0;
+    for(size_t k = 0; k < entries; k++){
+        maxWeight = max(maxWeight, values[k]);
+    }
+    delete distMatrix;
+    distMatrix = new DistanceMatrix(n, precision, maxWeight);
+    for(size_t k = 0; k < entries; k++){
+        distMatrix->setEntry(k, values[k]);
     }
 }
 
+/**
+ * @brief Sets the distance matrix of the graph to one built elsewhere, e.g. mapped from a cache file.
+ *
+ * @param matrix The matrix, indexed like the vertices of this graph. The graph takes ownership of it.
+ */
+
+void Graph::setDistMatrix(DistanceMatrix *matrix) {
+    delete distMatrix;
+    distMatrix = matrix;
+}
+
+/**
+ * @brief Replaces the distance matrix by the metric closure of the graph, keeping its precision.
+ *
+ * @param values The n(n-1)/2 shortest-path distances of the upper triangle, 0 for unreachable pairs.
+ * @param next The next hop from each vertex towards each other vertex, or nullptr if it was too large to keep. The
+ * graph takes ownership of it.
+ * @param connected Whether every pair of vertices is reachable.
+ */
+
+void Graph::setMetricClosure(const double *values, NextHopTable *next, bool connected) {
+    DistanceMatrix::Precision precision = distMatrix != nullptr ? distMatrix->getPrecision() : DistanceMatrix::defaultPrecision();
+    setDistMatrix(values, precision);
+    delete nextHops;
+    nextHops = next;
+    closure = connected;
+}
+
+/**
+ * @brief Sets the distance matrix to a metric closure built elsewhere, e.g. mapped from a cache file.
+ *
+ * @param matrix The shortest-path distances, indexed like the vertices of this graph. The graph takes ownership of it.
+ * @param next The next hop from each vertex towards each other vertex, or nullptr if it was too large to keep. The
+ * graph takes ownership of it.
+ * @param connected Whether every pair of vertices is reachable.
+ */
+
+void Graph::setMetricClosure(DistanceMatrix *matrix, NextHopTable *next, bool connected) {
+    setDistMatrix(matrix);
+    delete nextHops;
+    nextHops = next;
+    closure = connected;
+}
+
+/**
+ * @brief Checks if the distance matrix is the metric closure of a connected graph.
+ *
+ * @return True if every pair of vertices has a shortest-path distance, false otherwise.
+ */
+
+bool Graph::hasMetricClosure() const {
+    return closure;
+}
+
+/**
+ * @brief Returns the next hops of the metric closure.
+ *
+ * @return The table, or nullptr if there is no metric closure or it was too large to keep.
+ */
+
+const NextHopTable *Graph::getNextHops() const {
+    return nextHops;
+}
+
+/**
+ * @brief Returns the next vertex on the shortest path between two vertices.
+ *
+ * @param i The dense index of the vertex the path starts at.
+ * @param j The dense index of the vertex the path ends at.
+ * @return The dense index of the vertex after i, j itself if they are adjacent, or -1 if there is no next-hop
+ * table or no path.
+ */
+
+int Graph::getNextHop(int i, int j) const {
+    return nextHops == nullptr ? -1 : nextHops->get(i, j);
+}
+
 /**
  * @brief Get the optimal path for the Branch-and-Bound algorithm.
  *
@@ -214,10 +649,11 @@ void deleteMatrix(double **m, int n) {
 /**
  * @brief Destructor for the Graph class.
  *
- * Deletes the pathMatrix and distMatrix arrays.
+ * Deletes the next-hop table and the distance matrix. The vertices, and the edges they own, are freed together
+ * with the vertex arena.
  */
 
 Graph::~Graph() {
-    deleteMatrix(pathMatrix, vertexSet.size());
-    deleteMatrix(distMatrix, vertexSet.size());
+    delete nextHops;
+    delete distMatrix;
 }
@@ -11,12 +11,38 @@
 #include <limits>
 #include <algorithm>
 #include <unordered_map>
-#include "MutablePriorityQueue.h"
+#include <mutex>
 
 #include "VertexEdge.h"
+#include "CompactGraph.h"
+#include "DistanceMatrix.h"
+#include "Arena.h"
+#include "EdgeIndex.h"
+#include "CandidateSet.h"
+#include "NextHopTable.h"
 
 using namespace std;
 
+/**
+ * @brief The NodeRecord struct holds one parsed row of a nodes file.
+ */
+
+struct NodeRecord {
+    int id; /**< The ID of the vertex */
+    double longitude; /**< The longitude coordinate of the vertex */
+    double latitude; /**< The latitude coordinate of the vertex */
+};
+
+/**
+ * @brief The EdgeRecord struct holds one parsed row of an edges file.
+ */
+
+struct EdgeRecord {
+    int orig; /**< The ID of the source vertex */
+    int dest; /**< The ID of the destination vertex */
+    double weight; /**< The weight of the edge */
+};
+
 /**
  * @brief The Graph class is used to represent the graphs.
  */
@@ -27,7 +53,8 @@ public:
 /**
  * @brief Destructor for the Graph class.
  *
- * Deletes the pathMatrix and distMatrix arrays.
+ * Deletes the next-hop table and the distance matrix. The vertices, and the edges they own, are freed together
+ * with the vertex arena.
  */
 
     ~Graph();
@@ -74,13 +101,180 @@ public:
 /**
  * @brief Adds a bidirectional edge between two vertices in the graph with the given weight.
  *
+ * The edge is queued and only becomes part of the adjacency when buildAdjacency() runs.
+ *
  * @param sourc The ID of the source vertex.
  * @param dest The ID of the destination vertex.
  * @param w The weight of the edge.
  * @return True if the edge is added successfully, false otherwise.
  */
 
-    bool addBidirectionalEdge(const int &sourc, const int &dest, double w) const;
+    bool addBidirectionalEdge(const int &sourc, const int &dest, double w);
+
+/**
+ * @brief Adds a batch of vertices with coordinates to the graph.
+ *
+ * Reserves room for the whole batch before inserting, so the vertex set is rehashed at most once and the vertices
+ * are laid out in a single chunk of the arena.
+ *
+ * @param batches The parsed rows, one vector per parsing thread, inserted in order.
+ * @return The number of vertices that were added.
+ */
+
+    int addVertices(const vector<vector<NodeRecord>> &batches);
+
+/**
+ * @brief Adds a batch of bidirectional edges to the graph.
+ *
+ * @param batches The parsed rows, one vector per parsing thread, inserted in order.
+ * @return The number of edges that were added.
+ */
+
+    int addBidirectionalEdges(const vector<vector<EdgeRecord>> &batches);
+
+/**
+ * @brief Counts a bidirectional edge in the first pass of a streaming load.
+ *
+ * A streaming load counts every edge, calls allocateEdges() once and then places every edge with placeEdge(),
+ * writing straight into the adjacency without queueing.
+ *
+ * @param sourc The ID of the source vertex.
+ * @param dest The ID of the destination vertex.
+ * @return True if both vertices exist, false otherwise.
+ */
+
+    bool countEdge(const int &sourc, const int &dest);
+
+/**
+ * @brief Allocates the adjacency for every edge counted by countEdge().
+ */
+
+    void allocateEdges();
+
+/**
+ * @brief Places a bidirectional edge in the second pass of a streaming load.
+ *
+ * @param sourc The ID of the source vertex.
+ * @param dest The ID of the destination vertex.
+ * @param w The weight of the edge.
+ * @return True if both vertices exist, false otherwise.
+ */
+
+    bool placeEdge(const int &sourc, const int &dest, double w);
+
+/**
+ * @brief Moves the queued edges into the adjacency, counting degrees first so it is allocated once.
+ *
+ * Does nothing if the adjacency was already built. Edges added after this call are ignored.
+ */
+
+    void buildAdjacency();
+
+/**
+ * @brief Replaces the adjacency with one built elsewhere, e.g. by a snapshot.
+ *
+ * @param compact The adjacency, indexed like the vertices of this graph.
+ */
+
+    void setAdjacency(CompactGraph &&compact);
+
+/**
+ * @brief Renumbers the dense indices of the vertices.
+ *
+ * The adjacency, or the queued edges, follow the new numbering, and the dataset IDs move with their vertices, so
+ * idOf() still translates results back. The distance matrix, next hops, edge index and candidate lists are indexed by
+ * the old numbering and are dropped; renumbering is meant to run right after loading, before any of them is built.
+ *
+ * @param order The old dense index of the vertex at every new dense index, a permutation of 0..n-1.
+ */
+
+    void renumber(const vector<int> &order);
+
+/**
+ * @brief Returns the adjacency of the graph.
+ *
+ * @return The compact adjacency, indexed by Vertex::getIndex().
+ */
+
+    const CompactGraph &getAdjacency() const;
+
+/**
+ * @brief Builds the hash index of the edge weights, for graphs that get no distance matrix.
+ *
+ * Builds the adjacency first if needed.
+ */
+
+    void indexEdges();
+
+/**
+ * @brief Returns the hash index of the edge weights.
+ *
+ * @return The index, empty if indexEdges() was not called.
+ */
+
+    const EdgeIndex &getEdgeIndex() const;
+
+/**
+ * @brief Returns the storage held by the vertices.
+ *
+ * @return The number of bytes allocated by the vertex arena, used or not.
+ */
+
+    size_t vertexMemory() const;
+
+/**
+ * @brief Computes the candidate neighbour lists of every vertex, once the graph and its distances are loaded.
+ *
+ * @param k The most candidates per vertex.
+ * @param strategy How the candidates are chosen.
+ */
+
+    void buildCandidates(int k = CandidateSet::DEFAULT_K, CandidateSet::Strategy strategy = CandidateSet::NEAREST);
+
+/**
+ * @brief Returns the candidate neighbour lists, building them with the default parameters on first use.
+ *
+ * @return The lists.
+ */
+
+    const CandidateSet &getCandidates() const;
+
+/**
+ * @brief Translates a dataset ID into the dense index the algorithms work with.
+ *
+ * @param id The ID of the vertex.
+ * @return The dense index of the vertex, or -1 if there is no vertex with that ID.
+ */
+
+    int indexOf(int id) const;
+
+/**
+ * @brief Translates a dense index back into the dataset ID, for output.
+ *
+ * @param index The dense index of the vertex.
+ * @return The ID of the vertex.
+ */
+
+    int idOf(int index) const {
+        return ids[index];
+    }
+
+/**
+ * @brief Returns the dense index where every tour starts and ends.
+ *
+ * @return The index of the vertex with ID 0, or index 0 if there is no such vertex.
+ */
+
+    int getStartIndex() const;
+
+/**
+ * @brief Returns the vertex at a position of the adjacency.
+ *
+ * @param index The dense index of the vertex.
+ * @return Pointer to the vertex.
+ */
+
+    Vertex *vertexAt(int index) const;
 
 /**
  * @brief Returns the number of vertices in the graph.
@@ -90,6 +284,14 @@ public:
 
     int getNumVertex() const;
 
+/**
+ * @brief Checks if the vertices were loaded with coordinates.
+ *
+ * @return True if the graph was read together with a nodes file, false otherwise.
+ */
+
+    bool hasCoordinates() const;
+
 /**
  * @brief Returns a copy of the vertex set.
  *
@@ -101,15 +303,15 @@ public:
 /**
  * @brief Returns the distance matrix of the graph.
  *
- * @return The distance matrix of the graph.
+ * @return The distance matrix of the graph, or nullptr if it was not built.
  */
 
-    double ** getDistMatrix() const;
+    const DistanceMatrix * getDistMatrix() const;
 
 /**
  * @brief Sets the optimal path for the Branch-and-Bound algorithm.
  *
- * @param path The optimal path.
+ * @param path The optimal path, as dense indices.
  */
 
 
@@ -126,21 +328,104 @@ public:
 /**
  * @brief Sets the distance matrix of the graph.
  *
- * The distance matrix is a 2D array representing the distances between vertices in the graph.
- * Each element distMatrix[i][j] represents the distance between vertex i and vertex j.
+ * The distance matrix holds the distance between every pair of vertices, addressed by their dense indices, and 0
+ * for pairs that are not adjacent. Only its upper triangle is stored. Each row of the triangle is filled from the
+ * edges of one vertex, so the rows are filled in parallel.
+ *
+ * On graphs with coordinates, pairs that are not adjacent get their haversine distance instead of 0, the distance a
+ * DistanceOracle computes when the graph has no matrix, so a geo graph has the same distances whatever its size.
+ *
+ * @param precision The precision of the stored distances.
+ */
+
+    void setDistMatrix(DistanceMatrix::Precision precision = DistanceMatrix::defaultPrecision());
+
+/**
+ * @brief Sets the distance matrix of the graph from a precomputed block.
+ *
+ * @param values The n(n-1)/2 distances of the upper triangle in row-major order, where n is the number of vertices.
+ * @param precision The precision of the stored distances.
+ */
+
+    void setDistMatrix(const double *values, DistanceMatrix::Precision precision = DistanceMatrix::defaultPrecision());
+
+/**
+ * @brief Replaces the distance matrix by the metric closure of the graph, keeping its precision.
+ *
+ * @param values The n(n-1)/2 shortest-path distances of the upper triangle, 0 for unreachable pairs.
+ * @param next The next hop from each vertex towards each other vertex, or nullptr if it was too large to keep. The
+ * graph takes ownership of it.
+ * @param connected Whether every pair of vertices is reachable.
+ */
+
+    void setMetricClosure(const double *values, NextHopTable *next, bool connected);
+
+/**
+ * @brief Sets the distance matrix to a metric closure built elsewhere, e.g. mapped from a cache file.
+ *
+ * @param matrix The shortest-path distances, indexed like the vertices of this graph. The graph takes ownership of it.
+ * @param next The next hop from each vertex towards each other vertex, or nullptr if it was too large to keep. The
+ * graph takes ownership of it.
+ * @param connected Whether every pair of vertices is reachable.
+ */
+
+    void setMetricClosure(DistanceMatrix *matrix, NextHopTable *next, bool connected);
+
+/**
+ * @brief Checks if the distance matrix is the metric closure of a connected graph.
+ *
+ * @return True if every pair of vertices has a shortest-path distance, false otherwise.
+ */
+
+    bool hasMetricClosure() const;
+
+/**
+ * @brief Returns the next hops of the metric closure.
+ *
+ * @return The table, or nullptr if there is no metric closure or it was too large to keep.
+ */
+
+    const NextHopTable *getNextHops() const;
+
+/**
+ * @brief Returns the next vertex on the shortest path between two vertices.
+ *
+ * @param i The dense index of the vertex the path starts at.
+ * @param j The dense index of the vertex the path ends at.
+ * @return The dense index of the vertex after i, j itself if they are adjacent, or -1 if there is no next-hop
+ * table or no path.
+ */
+
+    int getNextHop(int i, int j) const;
+
+/**
+ * @brief Sets the distance matrix of the graph to one built elsewhere, e.g. mapped from a cache file.
+ *
+ * @param matrix The matrix, indexed like the vertices of this graph. The graph takes ownership of it.
  */
 
-    void setDistMatrix();
+    void setDistMatrix(DistanceMatrix *matrix);
 
 protected:
+    Arena<Vertex> vertexArena;    // storage of every vertex, declared first so it is destroyed last
     unordered_map<int, Vertex*> vertexSet;    // vertex set
+    vector<Vertex*> vertices;    // vertices by dense index
+    vector<int> ids;    // dataset ID of each dense index
+    CompactGraph adjacency;    // edges by dense index
+    EdgeIndex edgeIndex;    // edge weights by pair of dense indices
+    mutable CandidateSet candidates;    // nearest vertices of each dense index, built on first use
+    mutable mutex candidatesLock;    // guards the first build of candidates
+    vector<EdgeRecord> pending;    // edges (by dense index) waiting for buildAdjacency()
+    bool built = false;    // whether the adjacency was allocated
+    bool coordinates = false;    // whether the vertices have longitude and latitude
 
     //std::vector<std::vector<double>> distMatrix;   // dist matrix for Floyd-Warshall
-    int **pathMatrix = nullptr;   // path matrix for Floyd-Warshall
+    NextHopTable *nextHops = nullptr;   // next hop of every shortest path, filled by MetricClosure
+    bool closure = false;   // whether the distance matrix is the metric closure of a connected graph
 
     int *optPathBT = nullptr;
 
-    double ** distMatrix = nullptr;
+    DistanceMatrix *distMatrix = nullptr;
 
     /*
      * Finds the index of the vertex with a given content.
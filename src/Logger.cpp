@@ -0,0 +1,92 @@
+//
+// Created by oem on 03/06/23.
+//
+
+#include "Logger.h"
+#include <cstdlib>
+
+static const long CAPACITY = 1 << 16; /**< Buffered bytes before the sink is written out */
+
+/**
+ * Reads the initial verbosity level from the DA_LOG environment variable.
+ *
+ * @return The level named by DA_LOG, or QUIET if it is unset or unknown.
+ */
+
+static Logger::Level initialLevel() {
+    const char *value = getenv("DA_LOG");
+    if (value == nullptr) return Logger::QUIET;
+    string name(value);
+    if (name == "info") return Logger::INFO;
+    if (name == "debug") return Logger::DEBUG;
+    if (name == "trace") return Logger::TRACE;
+    return Logger::QUIET;
+}
+
+Logger::Level Logger::level = initialLevel();
+
+/**
+ * @brief Writes the pending messages when the program exits.
+ */
+
+struct LoggerFlusher {
+    ~LoggerFlusher() {
+        Logger::flush();
+    }
+};
+
+/**
+ * Gets the buffer the LOG macro formats into.
+ *
+ * @return The in-memory buffer of pending messages.
+ */
+
+ostringstream &Logger::buffer() {
+    static ostringstream pending;
+    static LoggerFlusher flusher;
+    return pending;
+}
+
+/**
+ * Writes the buffer out once it has grown past its capacity.
+ */
+
+void Logger::commit() {
+    if (buffer().tellp() >= CAPACITY) {
+        flush();
+    }
+}
+
+/**
+ * Writes every pending message to the standard output.
+ */
+
+void Logger::flush() {
+    ostringstream &pending = buffer();
+    if (pending.tellp() > 0) {
+        string text = pending.str();
+        cout.write(text.data(), (streamsize) text.size());
+        cout.flush();
+        pending.str(string());
+    }
+}
+
+/**
+ * Sets the verbosity level.
+ *
+ * @param value The most verbose level that is still written.
+ */
+
+void Logger::setLevel(Level value) {
+    level = value;
+}
+
+/**
+ * Gets the verbosity level.
+ *
+ * @return The most verbose level that is still written.
+ */
+
+Logger::Level Logger::getLevel() {
+    return level;
+}
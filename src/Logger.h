@@ -0,0 +1,106 @@
+//
+// Created by oem on 03/06/23.
+//
+
+#ifndef DA___2ND_PROJECT_LOGGER_H
+#define DA___2ND_PROJECT_LOGGER_H
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+/**
+ * @brief The Logger class is a leveled diagnostics facility with a buffered sink.
+ *
+ * Messages are accumulated in memory and written to the standard output in large blocks, so logging from a hot
+ * loop does not flush the terminal on every line. The level defaults to QUIET and can be raised with the DA_LOG
+ * environment variable ("info", "debug" or "trace") or with setLevel().
+ *
+ * @note The sink is not synchronised; only log from the thread that runs the menu.
+ */
+
+class Logger {
+public:
+
+/**
+ * The verbosity levels, from least to most verbose.
+ */
+
+    enum Level { QUIET = 0, INFO = 1, DEBUG = 2, TRACE = 3 };
+
+/**
+ * Sets the verbosity level.
+ *
+ * @param value The most verbose level that is still written.
+ */
+
+    static void setLevel(Level value);
+
+/**
+ * Gets the verbosity level.
+ *
+ * @return The most verbose level that is still written.
+ */
+
+    static Level getLevel();
+
+/**
+ * Checks if messages of a level are written.
+ *
+ * @param value The level of the message.
+ * @return True if the message should be formatted, false otherwise.
+ */
+
+    static bool enabled(Level value) {
+        return value <= level;
+    }
+
+/**
+ * Gets the buffer the LOG macro formats into.
+ *
+ * @return The in-memory buffer of pending messages.
+ */
+
+    static ostringstream &buffer();
+
+/**
+ * Writes the buffer out once it has grown past its capacity.
+ */
+
+    static void commit();
+
+/**
+ * Writes every pending message to the standard output.
+ */
+
+    static void flush();
+
+private:
+    static Level level; /**< The current verbosity level */
+};
+
+/**
+ * Levels above this one are compiled out entirely.
+ */
+
+#ifndef LOG_MAX_LEVEL
+#define LOG_MAX_LEVEL Logger::TRACE
+#endif
+
+/**
+ * Logs a message at the given level. The message is a stream expression, e.g. LOG(Logger::DEBUG, "x = " << x),
+ * and is only evaluated when the level is enabled.
+ */
+
+#define LOG(lvl, message) \
+    do { \
+        if ((lvl) <= LOG_MAX_LEVEL && Logger::enabled(lvl)) { \
+            Logger::buffer() << message << '\n'; \
+            Logger::commit(); \
+        } \
+    } while (0)
+
+
+#endif //DA___2ND_PROJECT_LOGGER_H
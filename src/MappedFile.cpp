@@ -0,0 +1,82 @@
+//
+// Created by oem on 01/06/23.
+//
+
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Maps the given file read-only.
+ *
+ * Empty files are reported as open with a size of zero, since mmap refuses zero-length mappings.
+ *
+ * @param file_name The path to the file.
+ * @param sequential Whether the file will be read front to back, so the kernel can read ahead and drop pages behind.
+ */
+
+MappedFile::MappedFile(const fs::path& file_name, bool sequential) {
+    int fd = open(file_name.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    struct stat info{};
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+        if (info.st_size == 0) {
+            begin = "";
+        } else {
+            void *addr = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                if (sequential) {
+                    madvise(addr, info.st_size, MADV_SEQUENTIAL);
+                }
+                begin = static_cast<const char *>(addr);
+                length = info.st_size;
+            }
+        }
+    }
+    close(fd);
+}
+
+/**
+ * Unmaps the file.
+ */
+
+MappedFile::~MappedFile() {
+    if (length > 0) {
+        munmap(const_cast<char *>(begin), length);
+    }
+}
+
+/**
+ * Checks if the file was mapped successfully.
+ *
+ * @return True if the mapping is usable, false otherwise.
+ */
+
+bool MappedFile::isOpen() const {
+    return begin != nullptr;
+}
+
+/**
+ * Gets the first byte of the mapping.
+ *
+ * @return A pointer to the mapped bytes.
+ */
+
+const char * MappedFile::data() const {
+    return begin;
+}
+
+/**
+ * Gets the size of the mapping.
+ *
+ * @return The size of the file in bytes.
+ */
+
+size_t MappedFile::size() const {
+    return length;
+}
@@ -0,0 +1,70 @@
+//
+// Created by oem on 01/06/23.
+//
+
+#ifndef DA___2ND_PROJECT_MAPPEDFILE_H
+#define DA___2ND_PROJECT_MAPPEDFILE_H
+
+#include <cstddef>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief The MappedFile class maps a whole file read-only into memory.
+ *
+ * The mapping is released when the object is destroyed, so the pointers returned by data() must not outlive it.
+ */
+
+class MappedFile {
+private:
+    const char *begin = nullptr; /**< Start of the mapping, nullptr if the file could not be mapped */
+    size_t length = 0; /**< Size of the mapping in bytes */
+
+public:
+
+/**
+ * Maps the given file read-only.
+ *
+ * @param file_name The path to the file.
+ * @param sequential Whether the file will be read front to back, so the kernel can read ahead and drop pages behind.
+ */
+
+    explicit MappedFile(const fs::path& file_name, bool sequential = true);
+
+/**
+ * Unmaps the file.
+ */
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+/**
+ * Checks if the file was mapped successfully.
+ *
+ * @return True if the mapping is usable, false otherwise.
+ */
+
+    bool isOpen() const;
+
+/**
+ * Gets the first byte of the mapping.
+ *
+ * @return A pointer to the mapped bytes.
+ */
+
+    const char * data() const;
+
+/**
+ * Gets the size of the mapping.
+ *
+ * @return The size of the file in bytes.
+ */
+
+    size_t size() const;
+};
+
+
+#endif //DA___2ND_PROJECT_MAPPEDFILE_H
@@ -0,0 +1,153 @@
+//
+// Created by oem on 08/06/23.
+//
+
+#include "MatrixCache.h"
+#include "Snapshot.h"
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <unistd.h>
+
+static const char MAGIC[8] = {'D', 'A', 'M', 'A', 'T', 'R', 'X', '\0'};
+
+/**
+ * @brief The fixed-size header at the start of every cache file. Its size keeps the entries 8-byte aligned.
+ */
+
+struct MatrixCacheHeader {
+    char magic[8]; /**< Always MAGIC */
+    uint32_t version; /**< MatrixCache::VERSION of the writer */
+    uint32_t precision; /**< The DistanceMatrix::Precision of the entries */
+    uint64_t key; /**< MatrixCache::key of the matrix */
+    uint64_t vertices; /**< Number of vertices */
+    double scale; /**< Distance of one quantization step */
+    uint64_t hopBytes; /**< Size of the next hops after the entries, 0 if there are none */
+    uint32_t connected; /**< 1 if the matrix is the metric closure of a connected graph, 0 otherwise */
+    uint32_t unused; /**< Zero */
+    uint64_t reserved; /**< Zero, pads the header to 64 bytes */
+};
+
+/**
+ * Computes the key of the distance matrix a graph would get.
+ *
+ * @param graph The loaded graph.
+ * @param precision The precision of the matrix.
+ * @param closure Whether the matrix is replaced by its metric closure.
+ * @return A hash of the number of vertices, every edge of the adjacency, the precision, the closure flag and whether
+ * the graph has coordinates, which fill the pairs that are not adjacent.
+ */
+
+uint64_t MatrixCache::key(const Graph& graph, DistanceMatrix::Precision precision, bool closure) {
+    const CompactGraph &adj = graph.getAdjacency();
+    const vector<uint32_t> &offsets = adj.getOffsets();
+    const vector<int> &targets = adj.getTargets();
+    const vector<double> &weights = adj.getWeights();
+    uint64_t seed = VERSION + ((uint64_t) precision << 32) + ((uint64_t) closure << 40) + ((uint64_t) graph.hasCoordinates() << 41);
+    uint64_t h = Snapshot::hash(offsets.data(), offsets.size() * sizeof(uint32_t), seed);
+    h = Snapshot::hash(targets.data(), targets.size() * sizeof(int), h);
+    return Snapshot::hash(weights.data(), weights.size() * sizeof(double), h);
+}
+
+/**
+ * Gets the cache file used for a matrix.
+ *
+ * @param edges_file The path to the edges CSV file of the dataset.
+ * @param key The key of the matrix.
+ * @return The path to the cache file, next to the edges file.
+ */
+
+fs::path MatrixCache::pathFor(const fs::path& edges_file, uint64_t key) {
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long) key);
+    fs::path path = edges_file;
+    path.replace_filename(edges_file.stem().string() + "-" + hex + ".matrix");
+    return path;
+}
+
+/**
+ * Writes the distance matrix of a graph to a cache file, with the next hops of its metric closure if it has any.
+ *
+ * @param graph The graph, with a distance matrix.
+ * @param file_name The path to the cache file.
+ * @param key The key of the matrix.
+ * @return True if the file was written, false otherwise.
+ */
+
+bool MatrixCache::write(const Graph& graph, const fs::path& file_name, uint64_t key) {
+    const DistanceMatrix &matrix = *graph.getDistMatrix();
+    const NextHopTable *next = graph.getNextHops();
+    MatrixCacheHeader header{};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.precision = matrix.getPrecision();
+    header.key = key;
+    header.vertices = matrix.getNumVertex();
+    header.scale = matrix.getScale();
+    header.hopBytes = next == nullptr ? 0 : next->memoryUsage();
+    header.connected = graph.hasMetricClosure();
+
+    fs::path temporary = file_name;
+    temporary += ".tmp" + to_string(getpid());
+    ofstream out(temporary, ios::binary | ios::trunc);
+    if (!out) {
+        return false;
+    }
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(static_cast<const char *>(matrix.data()), matrix.memoryUsage());
+    if (next != nullptr) {
+        out.write(static_cast<const char *>(next->data()), header.hopBytes);
+    }
+    out.close();
+
+    error_code ec;
+    if (!out) {
+        fs::remove(temporary, ec);
+        return false;
+    }
+    fs::rename(temporary, file_name, ec);
+    if (ec) {
+        fs::remove(temporary, ec);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Gives a graph the distance matrix of a cache file, mapped read-only, and the next hops stored with it.
+ *
+ * The entries stay in the mapping; the next hops are copied into a NextHopTable, which is a fraction of the time
+ * the closure took to compute them.
+ *
+ * @param graph The loaded graph, which keeps its matrix if the file does not match.
+ * @param file_name The path to the cache file.
+ * @param key The key of the expected matrix.
+ * @param precision The precision of the expected matrix.
+ * @return True if the graph got the matrix, false if the file is missing or does not match.
+ */
+
+bool MatrixCache::load(Graph& graph, const fs::path& file_name, uint64_t key, DistanceMatrix::Precision precision) {
+    auto file = make_unique<MappedFile>(file_name, false);
+    if (!file->isOpen() || file->size() < sizeof(MatrixCacheHeader)) {
+        return false;
+    }
+    MatrixCacheHeader header{};
+    memcpy(&header, file->data(), sizeof(header));
+    int n = graph.getNumVertex();
+    size_t entries = n < 2 ? 0 : (size_t) n * (n - 1) / 2;
+    size_t matrixBytes = entries * DistanceMatrix::bytesPerEntry(precision);
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION || header.key != key
+        || header.precision != (uint32_t) precision || header.vertices != (uint64_t) n
+        || (header.hopBytes != 0 && header.hopBytes != NextHopTable::bytesFor(n))
+        || file->size() - sizeof(header) != matrixBytes + header.hopBytes) {
+        return false;
+    }
+    NextHopTable *next = nullptr;
+    if (header.hopBytes != 0) {
+        next = new NextHopTable(n);
+        memcpy(next->data(), static_cast<const char *>(file->data()) + sizeof(header) + matrixBytes, header.hopBytes);
+    }
+    bool connected = header.connected != 0;
+    graph.setMetricClosure(new DistanceMatrix(n, precision, header.scale, std::move(file), sizeof(header)), next, connected);
+    return true;
+}
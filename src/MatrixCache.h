@@ -0,0 +1,83 @@
+//
+// Created by oem on 08/06/23.
+//
+
+#ifndef DA___2ND_PROJECT_MATRIXCACHE_H
+#define DA___2ND_PROJECT_MATRIXCACHE_H
+
+#include <cstdint>
+#include <filesystem>
+#include "Graph.h"
+#include "DistanceMatrix.h"
+
+namespace fs = std::filesystem;
+using namespace std;
+
+/**
+ * @brief The MatrixCache class keeps computed distance matrices in files that later runs map instead of rebuilding.
+ *
+ * A cache file holds a small header followed by the entries of a DistanceMatrix exactly as they are laid out in
+ * memory, so mapping it read-only gives a usable matrix without copying. When the metric closure is enabled the file
+ * holds the matrix after MetricClosure::apply, followed by its next hops if they were kept, so a later run skips the
+ * shortest-path computation as well. Its name carries a hash of the adjacency, the precision and whether the closure
+ * is enabled, so a changed dataset, precision or DA_CLOSURE simply misses the cache. Files are written under a temporary
+ * name and renamed into place, so concurrent processes never map a partial file.
+ */
+
+class MatrixCache {
+public:
+
+/**
+ * The current version of the cache format. Files with any other version are ignored.
+ */
+
+    static constexpr uint32_t VERSION = 2;
+
+/**
+ * Computes the key of the distance matrix a graph would get.
+ *
+ * @param graph The loaded graph.
+ * @param precision The precision of the matrix.
+ * @param closure Whether the matrix is replaced by its metric closure.
+ * @return A hash of the number of vertices, every edge of the adjacency, the precision, the closure flag and whether
+ * the graph has coordinates, which fill the pairs that are not adjacent.
+ */
+
+    static uint64_t key(const Graph& graph, DistanceMatrix::Precision precision, bool closure);
+
+/**
+ * Gets the cache file used for a matrix.
+ *
+ * @param edges_file The path to the edges CSV file of the dataset.
+ * @param key The key of the matrix.
+ * @return The path to the cache file, next to the edges file.
+ */
+
+    static fs::path pathFor(const fs::path& edges_file, uint64_t key);
+
+/**
+ * Writes the distance matrix of a graph to a cache file, with the next hops of its metric closure if it has any.
+ *
+ * @param graph The graph, with a distance matrix.
+ * @param file_name The path to the cache file.
+ * @param key The key of the matrix.
+ * @return True if the file was written, false otherwise.
+ */
+
+    static bool write(const Graph& graph, const fs::path& file_name, uint64_t key);
+
+/**
+ * Gives a graph the distance matrix of a cache file, mapped read-only, and the next hops stored with it.
+ *
+ * @param graph The loaded graph, which keeps its matrix if the file does not match.
+ * @param file_name The path to the cache file.
+ * @param key The key of the expected matrix.
+ * @param precision The precision of the expected matrix.
+ * @return True if the graph got the matrix, false if the file is missing or does not match.
+ */
+
+    static bool load(Graph& graph, const fs::path& file_name, uint64_t key, DistanceMatrix::Precision precision);
+};
+
+
+#endif //DA___2ND_PROJECT_MATRIXCACHE_H
@@ -63,6 +63,24 @@ void Menu::Display() {
     Menu::selectData(entry);
 }
 
+/**
+ * Finds the file of a real-world graph, which may be archived compressed.
+ *
+ * @param directory The directory of the graph.
+ * @param name The name of the file without extension, "nodes" or "edges".
+ * @return The path to name.csv, name.csv.gz or name.csv.zst, or an empty path if there is none.
+ */
+
+static fs::path findInput(const fs::path &directory, const string &name) {
+    for (const char *extension : {".csv", ".csv.gz", ".csv.zst"}) {
+        fs::path candidate = directory / (name + extension);
+        if (fs::exists(candidate)) {
+            return candidate;
+        }
+    }
+    return {};
+}
+
 /**
  * Selects the data based on the given directory entry.
  *
@@ -74,7 +92,7 @@ void Menu::selectData(const fs::directory_entry& selected) {
     std::vector<fs::directory_entry> entries;
     int i = 1;
     for (auto &entry: fs::directory_iterator(selected.path())) {
-        if (entry.path().filename() != ".DS_Store") {  // Skip ".DS_Store" file
+        if (entry.path().filename() != ".DS_Store" && entry.path().extension() != ".snapshot" && entry.path().extension() != ".matrix") {  // Skip ".DS_Store" and cache files
             entries.push_back(entry);
         }
     }
@@ -97,14 +115,13 @@ void Menu::selectData(const fs::directory_entry& selected) {
     }
     else if(entries[a-1].is_directory()){
         Menu::setEntry(entries[a-1]);
-        if(entries[a-1].path().filename() == "graph1" || entries[a-1].path().filename() == "graph2" || entries[a-1].path().filename() == "graph3"){
-            for (auto &entry: fs::directory_iterator(selected.path())) {
-                if (entry.path().filename() == "edges.csv") {  // Skip ".DS_Store" file
-                    Menu::setEdges(entry.path());
-                }
-                else if(entry.path().filename() == "nodes.csv"){
-                    Menu::setNodes(entry.path());
-                }
+        // Any directory with an edges file is a real-world graph, whatever its size
+        fs::path edgesFile = findInput(entries[a-1].path(), "edges");
+        if(!edgesFile.empty()){
+            Menu::setEdges(edgesFile);
+            fs::path nodesFile = findInput(entries[a-1].path(), "nodes");
+            if(!nodesFile.empty()){
+                Menu::setNodes(nodesFile);
             }
             Menu::selectFunctions();
         }
@@ -121,6 +138,160 @@ void Menu::selectData(const fs::directory_entry& selected) {
         cout << "Unknown Error" << endl;
 }
 
+/**
+ * Loads the selected dataset into a graph and builds its distance matrix.
+ *
+ * @brief Loads the selected dataset.
+ * @param graph The graph to fill.
+ * @param reader The reader configured for the selected dataset.
+ * @param strategy The order to renumber the vertices in.
+ */
+
+void Menu::loadGraph(Graph &graph, FileReader &reader, Renumbering::Strategy strategy) {
+    Menu::readGraph(graph, reader);
+    Menu::prepareGraph(graph, strategy);
+}
+
+/**
+ * Reads the vertices and edges of the selected dataset into a graph, in the order of the dataset.
+ *
+ * A binary snapshot next to the edges file is used when it matches the current CSV files; otherwise the CSV files
+ * are parsed and the snapshot is rewritten.
+ *
+ * @brief Reads the selected dataset.
+ * @param graph The graph to fill.
+ * @param reader The reader configured for the selected dataset.
+ */
+
+void Menu::readGraph(Graph &graph, FileReader &reader) {
+    fs::path snapshot = Snapshot::pathFor(edges);
+    uint64_t fingerprint = Snapshot::fingerprint({nodes, edges});
+    auto startTime = chrono::high_resolution_clock::now();
+    if(Snapshot::read(graph, snapshot, fingerprint)){
+        std::chrono::duration<double> duration = chrono::high_resolution_clock::now() - startTime;
+        cout << "\tLoaded snapshot " << snapshot.filename() << " in " << duration.count() << " seconds" << endl;
+    }
+    else{
+        bool complete = reader.read(graph, nodes, edges);
+        if(reader.isMapped()){
+            const LoadStats& stats = reader.getStats();
+            cout << "\tLoaded " << stats.rows << " rows in " << stats.seconds << " seconds ("
+                 << stats.rowsPerSecond() << " rows/s, " << stats.megabytesPerSecond() << " MB/s)" << endl;
+        }
+        // Never cache a graph that was only partly read
+        if(complete){
+            Snapshot::write(graph, snapshot, fingerprint);
+        }
+    }
+}
+
+/**
+ * Renumbers the vertices of a freshly loaded graph and builds its distance matrix.
+ *
+ * A matrix with non-adjacent pairs is replaced by its metric closure unless DA_CLOSURE is "off".
+ *
+ * @brief Prepares a loaded graph for the algorithms.
+ * @param graph The loaded graph.
+ * @param strategy The order to renumber the vertices in.
+ */
+
+void Menu::prepareGraph(Graph &graph, Renumbering::Strategy strategy) {
+    auto startTime = chrono::high_resolution_clock::now();
+    if(strategy != Renumbering::NONE){
+        graph.buildAdjacency();
+        graph.renumber(Renumbering::order(graph, strategy));
+        std::chrono::duration<double> duration = chrono::high_resolution_clock::now() - startTime;
+        LOG(Logger::INFO, "Renumbered the vertices in " << Renumbering::name(strategy) << " order in " << duration.count() << " seconds");
+    }
+    Menu::loadDistMatrix(graph);
+}
+
+/**
+ * Gives the graph its distance matrix, mapping it from the matrix cache when an earlier run already built it.
+ *
+ * Graphs with coordinates whose matrix would exceed DistanceOracle::MAX_MATRIX_BYTES get no matrix; their distances
+ * are computed on demand instead, with edge weights looked up in a hash index of the edges. Other matrices are cached
+ * after their metric closure, so a cached matrix comes back with its shortest paths and next hops.
+ *
+ * @brief Loads or builds the distance matrix.
+ * @param graph The loaded graph.
+ */
+
+void Menu::loadDistMatrix(Graph &graph) {
+    if(!DistanceOracle::wantsMatrix(graph)){
+        graph.indexEdges();
+        return;
+    }
+    DistanceMatrix::Precision precision = DistanceMatrix::defaultPrecision();
+    uint64_t key = MatrixCache::key(graph, precision, MetricClosure::enabled());
+    fs::path cache = MatrixCache::pathFor(edges, key);
+    if(MatrixCache::load(graph, cache, key, precision)){
+        LOG(Logger::INFO, "Mapped distance matrix " << cache.filename());
+        return;
+    }
+    graph.setDistMatrix(precision);
+    Menu::closeDistMatrix(graph);
+    MatrixCache::write(graph, cache, key);
+}
+
+/**
+ * Replaces the distance matrix by its metric closure when some pair is not adjacent, unless DA_CLOSURE is "off".
+ *
+ * @brief Completes the distance matrix with shortest paths.
+ * @param graph The graph, with a distance matrix.
+ */
+
+void Menu::closeDistMatrix(Graph &graph) {
+    auto startTime = chrono::high_resolution_clock::now();
+    if(MetricClosure::enabled() && MetricClosure::apply(graph)){
+        std::chrono::duration<double> duration = chrono::high_resolution_clock::now() - startTime;
+        LOG(Logger::INFO, "Completed the distance matrix with shortest paths in " << duration.count() << " seconds");
+    }
+}
+
+/**
+ * Prints the vertices a tour travels through when its legs over the metric closure are expanded into roads. The legs
+ * are expanded while they are printed, so nothing proportional to the road path is stored.
+ *
+ * @brief Prints the road path of a tour.
+ * @param graph The graph, with the tour stored as its optimal path.
+ */
+
+void Menu::printRoadPath(Graph &graph) {
+    if(!graph.hasMetricClosure()){
+        return;
+    }
+    RoadPath road(graph, graph.getOptPathBT(), graph.getNumVertex());
+    cout << "\tRoad path : [" << graph.idOf(graph.getOptPathBT()[0]);
+    for(const RoadStep &step : road){
+        cout << " -> " << graph.idOf(step.to);
+    }
+    cout << "]" << endl;
+}
+
+/**
+ * Prints the Held-Karp lower bound of the graph and how far a tour is at most from the shortest one.
+ *
+ * @brief Prints the optimality gap of a tour.
+ * @param graph The graph the tour was found on.
+ * @param service The services used to compute the bound.
+ * @param length The length of the tour.
+ */
+
+void Menu::printGap(const Graph &graph, Services &service, double length) {
+    double bound = service.lowerBound(graph, length);
+    // No 1-tree was complete in time, or there is no tour to compare with
+    if(bound <= 0 || bound == numeric_limits<double>::infinity()){
+        return;
+    }
+    Logger::flush();
+    double gap = (length - bound) / bound;
+    if(gap < Services::GAP_TOLERANCE){
+        gap = 0;
+    }
+    cout << "\tLower bound : " << bound << " (the tour is at most " << 100 * gap << "% longer than the shortest one)" << endl;
+}
+
 /**
  * Displays the options for selecting different algorithms and performs the selected algorithm based on user input.
  *
@@ -133,6 +304,11 @@ void Menu::selectFunctions() {
     cout << "\t1) Backtracking Algorithm" << endl;
     cout << "\t2) Triangular Approximation Heuristic" << endl;
     cout << "\t3) Genetic Algorithm" << endl;
+    cout << "\t4) Load/unload memory benchmark" << endl;
+    cout << "\t5) Vertex renumbering benchmark" << endl;
+    cout << "\t6) Held-Karp Dynamic Programming" << endl;
+    cout << "\t7) Branch and Bound" << endl;
+    cout << "\t8) Backtracking kernel benchmark" << endl;
 
     cout << "\n\t0) Exit " << endl;
     bool verify=!nodes.empty();
@@ -146,13 +322,8 @@ void Menu::selectFunctions() {
     else if(a == 1){
         // Perform Backtracking Algorithm
         Graph graph;
-        if(reader.verify()){
-            reader.readNodes(graph, nodes);
-            reader.readEdges2(graph, edges);
-        }
-        else{reader.readEdges1(graph, edges );}
-        graph.setDistMatrix();
-        int path[graph.getVertexSet().size()];
+        Menu::loadGraph(graph, reader);
+        int path[graph.getNumVertex()];
         auto startTime = chrono::high_resolution_clock::now();
         double res = service.BT(graph, path);
         if(res == -1){
@@ -162,16 +333,25 @@ void Menu::selectFunctions() {
         auto endTime = chrono::high_resolution_clock::now();
         std::chrono::duration<double> duration = endTime - startTime;
         graph.setOptPathBT(path);
+        Logger::flush();
         cout << "\n\t\t\t===================" << endl;
         cout << "\n";
         cout << "\tMinimum distance : " << res << endl;
         cout << "\tOptimal path : [";
-        for(int i=0; i<graph.getVertexSet().size(); i++){
-            cout << graph.getOptPathBT()[i] << " -> ";
+        for(int i=0; i<graph.getNumVertex(); i++){
+            cout << graph.idOf(graph.getOptPathBT()[i]) << " -> ";
         }
-        cout <<"0]" << endl;
+        cout << graph.idOf(graph.getOptPathBT()[0]) << "]" << endl;
+        Menu::printRoadPath(graph);
+        Menu::printGap(graph, service, res);
 
         cout << "\n\t\tExecution time: " << duration.count() << " seconds" << endl;
+        const vector<SearchStats> &threads = service.getSearchStats();
+        for (size_t i = 0; i < threads.size(); i++) {
+            double rate = threads[i].seconds > 0 ? threads[i].nodes / threads[i].seconds : 0;
+            cout << "\t\tThread " << i << " : " << threads[i].nodes << " nodes, " << (long long) rate << " nodes/s, "
+                 << threads[i].tasks << " tasks, " << threads[i].steals << " stolen" << endl;
+        }
 
         cout << "\n\t\t\t===================" << endl;
         cout << "\n";
@@ -180,12 +360,7 @@ void Menu::selectFunctions() {
    else if( a == 2) {
         // Perform Triangular Approximation Heuristic
         Graph graph;
-        if(reader.verify()){
-            reader.readNodes(graph, nodes);
-            reader.readEdges2(graph, edges);
-        }
-        else{reader.readEdges1(graph, edges );}
-        graph.setDistMatrix();
+        Menu::loadGraph(graph, reader);
         int path[graph.getNumVertex()];
         auto startTime = chrono::high_resolution_clock::now();
         double res = service.TAH(graph, path);
@@ -194,14 +369,19 @@ void Menu::selectFunctions() {
         auto endTime = chrono::high_resolution_clock::now();
         std::chrono::duration<double> duration = endTime - startTime;
 
+        Logger::flush();
         cout << "\n\t\t\t===================" << endl;
         cout << "\n";
-        cout << "\tOptimal path (MST in preorder) : [";
-        for(int i=0; i<graph.getVertexSet().size(); i++){
-            cout << graph.getOptPathBT()[i] << " -> ";
+        cout << "\tOptimal path (MST in preorder, shortened by 2-opt) : [";
+        for(int i=0; i<graph.getNumVertex(); i++){
+            cout << graph.idOf(graph.getOptPathBT()[i]) << " -> ";
         }
-        cout <<"0]" << endl;
+        cout << graph.idOf(graph.getOptPathBT()[0]) << "]" << endl;
+        Menu::printRoadPath(graph);
         cout << "\tMinimum distance (at most twice the cost of the best solution) : " << res << endl;
+        double length = service.pathCost(path);
+        cout << "\tTour length : " << length << endl;
+        Menu::printGap(graph, service, length);
         cout << "\n\t\tExecution time: " << duration.count() << " seconds" << endl;
 
         cout << "\n\t\t\t===================" << endl;
@@ -211,12 +391,7 @@ void Menu::selectFunctions() {
    else if(a==3) {
         // Perform Genetic Algorithm
         Graph graph;
-        if(reader.verify()){
-            reader.readNodes(graph, nodes);
-            reader.readEdges2(graph, edges);
-        }
-        else{reader.readEdges1(graph, edges );}
-        graph.setDistMatrix();
+        Menu::loadGraph(graph, reader);
         int path[graph.getNumVertex()];
         auto startTime = chrono::high_resolution_clock::now();
         double res = service.GA(graph, path);
@@ -225,17 +400,181 @@ void Menu::selectFunctions() {
         auto endTime = chrono::high_resolution_clock::now();
         std::chrono::duration<double> duration = endTime - startTime;
 
+        Logger::flush();
         cout << "\n\t\t\t===================" << endl;
         cout << "\n";
         cout << "\tPath : [";
-        for(int i=0; i<graph.getVertexSet().size(); i++){
-            cout << graph.getOptPathBT()[i] << " -> ";
+        for(int i=0; i<graph.getNumVertex(); i++){
+            cout << graph.idOf(graph.getOptPathBT()[i]) << " -> ";
+        }
+        cout << graph.idOf(graph.getOptPathBT()[0]) << "]" << endl;
+        Menu::printRoadPath(graph);
+        cout << "\tMinimum distance : " << res << endl;
+        Menu::printGap(graph, service, service.pathCost(path));
+        cout << "\n\t\tExecution time: " << duration.count() << " seconds" << endl;
+
+        cout << "\n\t\t\t===================" << endl;
+        cout << "\n";
+    }
+
+   else if(a==4) {
+        // Reload the dataset a few times and check that its memory is given back every time
+        const int rounds = 5;
+        size_t baseline = 0;
+        vector<MemorySample> samples = Benchmark::loadUnload([this, &reader](Graph &graph) {
+            Menu::loadGraph(graph, reader);
+        }, rounds, baseline);
+
+        Logger::flush();
+        cout << "\n\t\t\t===================" << endl;
+        cout << "\n";
+        cout << "\tBaseline RSS : " << baseline / 1024 << " KiB" << endl;
+        for(int i=0; i<(int) samples.size(); i++){
+            cout << "\tRound " << i + 1 << " : loaded in " << samples[i].seconds << " seconds, RSS "
+                 << samples[i].loaded / 1024 << " KiB loaded, " << samples[i].unloaded / 1024 << " KiB unloaded" << endl;
         }
-        cout <<"0]" << endl;
+        const StructureMemory &memory = samples.back().structures;
+        cout << "\n\tVertices : " << memory.vertices / 1024 << " KiB" << endl;
+        cout << "\tAdjacency : " << memory.adjacency / 1024 << " KiB" << endl;
+        cout << "\tEdge index : " << memory.edgeIndex / 1024 << " KiB" << endl;
+        cout << "\tCandidates : " << memory.candidates / 1024 << " KiB" << endl;
+        cout << "\tDistance matrix : " << memory.matrix / 1024 << " KiB" << endl;
+        cout << "\tNext hops : " << memory.nextHops / 1024 << " KiB" << endl;
+        cout << "\n\t\t\t===================" << endl;
+        cout << "\n";
+    }
+
+   else if(a==5) {
+        // Prepare the dataset and run the approximation in its own order and renumbered, counting cache misses
+        Renumbering::Strategy renumbered = Renumbering::fromEnvironment();
+        if(renumbered == Renumbering::NONE){
+            renumbered = Renumbering::AUTO;
+        }
+        const string phases[] = {"Prepare", "Triangular approximation"};
+        vector<pair<Renumbering::Strategy, vector<CacheSample>>> results;
+        for(Renumbering::Strategy strategy : {Renumbering::NONE, renumbered}){
+            Graph graph;
+            Menu::readGraph(graph, reader);
+            vector<CacheSample> samples;
+            samples.push_back(Benchmark::countCacheMisses([this, &graph, strategy]() {
+                Menu::prepareGraph(graph, strategy);
+            }));
+            vector<int> path(graph.getNumVertex());
+            samples.push_back(Benchmark::countCacheMisses([&service, &graph, &path]() {
+                service.TAH(graph, path.data());
+            }));
+            results.emplace_back(strategy, samples);
+        }
+
+        Logger::flush();
+        cout << "\n\t\t\t===================" << endl;
+        cout << "\n";
+        for(const auto &result : results){
+            cout << "\t" << Renumbering::name(result.first) << " :" << endl;
+            for(int i=0; i<(int) result.second.size(); i++){
+                const CacheSample &sample = result.second[i];
+                cout << "\t\t" << phases[i] << " : " << sample.seconds << " seconds";
+                if(sample.counted){
+                    cout << ", " << sample.misses << " of " << sample.references << " cache references missed";
+                }
+                cout << endl;
+            }
+        }
+        if(!results.front().second.front().counted){
+            cout << "\n\tCache counters are not available on this machine" << endl;
+        }
+        cout << "\n\t\t\t===================" << endl;
+        cout << "\n";
+    }
+
+   else if(a==6) {
+        // Perform Held-Karp Dynamic Programming
+        Graph graph;
+        Menu::loadGraph(graph, reader);
+        int path[graph.getNumVertex()];
+        auto startTime = chrono::high_resolution_clock::now();
+        double res = service.HK(graph, path);
+        if(res == -1){
+            cout << "\nThis service is no feasible for the given data" << endl;
+            exit(0);
+        }
+        auto endTime = chrono::high_resolution_clock::now();
+        std::chrono::duration<double> duration = endTime - startTime;
+        graph.setOptPathBT(path);
+        Logger::flush();
+        cout << "\n\t\t\t===================" << endl;
+        cout << "\n";
         cout << "\tMinimum distance : " << res << endl;
+        cout << "\tOptimal path : [";
+        for(int i=0; i<graph.getNumVertex(); i++){
+            cout << graph.idOf(graph.getOptPathBT()[i]) << " -> ";
+        }
+        cout << graph.idOf(graph.getOptPathBT()[0]) << "]" << endl;
+        Menu::printRoadPath(graph);
+        Menu::printGap(graph, service, res);
+
+        cout << "\n\t\tExecution time: " << duration.count() << " seconds" << endl;
+
+        cout << "\n\t\t\t===================" << endl;
+        cout << "\n";
+    }
+
+   else if(a==7) {
+        // Perform Branch and Bound
+        Graph graph;
+        Menu::loadGraph(graph, reader);
+        int path[graph.getNumVertex()];
+        auto startTime = chrono::high_resolution_clock::now();
+        double res = service.BB(graph, path);
+        if(res == -1){
+            cout << "\nThis service is no feasible for the given data" << endl;
+            exit(0);
+        }
+        auto endTime = chrono::high_resolution_clock::now();
+        std::chrono::duration<double> duration = endTime - startTime;
+        graph.setOptPathBT(path);
+        Logger::flush();
+        cout << "\n\t\t\t===================" << endl;
+        cout << "\n";
+        cout << "\tMinimum distance" << (service.isOptimal() ? "" : " (best found in the time limit)") << " : " << res << endl;
+        cout << "\tOptimal path : [";
+        for(int i=0; i<graph.getNumVertex(); i++){
+            cout << graph.idOf(graph.getOptPathBT()[i]) << " -> ";
+        }
+        cout << graph.idOf(graph.getOptPathBT()[0]) << "]" << endl;
+        Menu::printRoadPath(graph);
+        Menu::printGap(graph, service, res);
+
         cout << "\n\t\tExecution time: " << duration.count() << " seconds" << endl;
 
         cout << "\n\t\t\t===================" << endl;
         cout << "\n";
     }
+
+   else if(a==8) {
+        // Run the old recursive backtracking and the search kernel on one thread, for the same time at most
+        Graph graph;
+        Menu::loadGraph(graph, reader);
+        DistanceOracle distances(graph);
+        const string names[] = {"Recursive search", "Search kernel"};
+        SearchSample samples[] = {
+            Benchmark::recursiveBacktracking(distances, graph.getStartIndex(), Benchmark::SEARCH_SECONDS),
+            Benchmark::backtrackingKernel(distances, graph.getStartIndex(), Benchmark::SEARCH_SECONDS)
+        };
+
+        Logger::flush();
+        cout << "\n\t\t\t===================" << endl;
+        cout << "\n";
+        double rates[2];
+        for(int i=0; i<2; i++){
+            rates[i] = samples[i].seconds > 0 ? samples[i].nodes / samples[i].seconds : 0;
+            cout << "\t" << names[i] << " : " << samples[i].nodes << " nodes in " << samples[i].seconds << " seconds, "
+                 << (long long) rates[i] << " nodes/s" << (samples[i].finished ? "" : " (stopped)") << endl;
+        }
+        if(rates[0] > 0){
+            cout << "\n\tSpeedup : " << rates[1] / rates[0] << "x" << endl;
+        }
+        cout << "\n\t\t\t===================" << endl;
+        cout << "\n";
+    }
 }
@@ -13,6 +13,12 @@
 #include <chrono>
 #include "FileReader.h"
 #include "Services.h"
+#include "Snapshot.h"
+#include "MatrixCache.h"
+#include "Benchmark.h"
+#include "MetricClosure.h"
+#include "RoadPath.h"
+#include "Renumbering.h"
 
 
 using namespace std;
@@ -66,6 +72,76 @@ public:
 
     void selectFunctions();
 
+/**
+ * Loads the selected dataset into a graph and builds its distance matrix.
+ *
+ * @brief Loads the selected dataset.
+ * @param graph The graph to fill.
+ * @param reader The reader configured for the selected dataset.
+ * @param strategy The order to renumber the vertices in, by default the one named by DA_REORDER.
+ */
+
+    void loadGraph(Graph &graph, FileReader &reader, Renumbering::Strategy strategy = Renumbering::fromEnvironment());
+
+/**
+ * Reads the vertices and edges of the selected dataset into a graph, in the order of the dataset.
+ *
+ * @brief Reads the selected dataset.
+ * @param graph The graph to fill.
+ * @param reader The reader configured for the selected dataset.
+ */
+
+    void readGraph(Graph &graph, FileReader &reader);
+
+/**
+ * Renumbers the vertices of a freshly loaded graph and builds its distance matrix.
+ *
+ * @brief Prepares a loaded graph for the algorithms.
+ * @param graph The loaded graph.
+ * @param strategy The order to renumber the vertices in.
+ */
+
+    void prepareGraph(Graph &graph, Renumbering::Strategy strategy);
+
+/**
+ * Gives the graph its distance matrix, mapping it from the matrix cache when an earlier run already built it.
+ *
+ * @brief Loads or builds the distance matrix.
+ * @param graph The loaded graph.
+ */
+
+    void loadDistMatrix(Graph &graph);
+
+/**
+ * Replaces the distance matrix by its metric closure when some pair is not adjacent, unless DA_CLOSURE is "off".
+ *
+ * @brief Completes the distance matrix with shortest paths.
+ * @param graph The graph, with a distance matrix.
+ */
+
+    void closeDistMatrix(Graph &graph);
+
+/**
+ * Prints the vertices a tour travels through when its legs over the metric closure are expanded into roads. The legs
+ * are expanded while they are printed, so nothing proportional to the road path is stored.
+ *
+ * @brief Prints the road path of a tour.
+ * @param graph The graph, with the tour stored as its optimal path.
+ */
+
+    void printRoadPath(Graph &graph);
+
+/**
+ * Prints the Held-Karp lower bound of the graph and how far a tour is at most from the shortest one.
+ *
+ * @brief Prints the optimality gap of a tour.
+ * @param graph The graph the tour was found on.
+ * @param service The services used to compute the bound.
+ * @param length The length of the tour.
+ */
+
+    void printGap(const Graph &graph, Services &service, double length);
+
 /**
  * Sets the directory entry for the Menu class.
  *
@@ -0,0 +1,229 @@
+//
+// Created by oem on 12/06/23.
+//
+
+#include "MetricClosure.h"
+#include "Parallel.h"
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <queue>
+#include <string>
+
+static const double UNREACHABLE = numeric_limits<double>::infinity();
+
+/**
+ * @brief Reads whether the closure is wanted from the DA_CLOSURE environment variable.
+ *
+ * @return False for "off" or "0", true otherwise.
+ */
+
+bool MetricClosure::enabled() {
+    const char *value = getenv("DA_CLOSURE");
+    if (value == nullptr) return true;
+    string name(value);
+    return name != "off" && name != "0";
+}
+
+/**
+ * @brief Replaces the distance matrix of a graph by its metric closure, if some pair of vertices is not adjacent.
+ *
+ * Floyd-Warshall does the same work whatever the number of edges, while Dijkstra's grows with it, so Floyd-Warshall
+ * is used once the graph is dense enough for Dijkstra's heap operations to cost more than its n^3 tight loops. The
+ * next hops are only kept if their table fits in MAX_TABLE_BYTES.
+ *
+ * @param graph The graph, with a distance matrix.
+ * @return True if the matrix was replaced, false if the graph has no matrix or every pair is already adjacent.
+ */
+
+bool MetricClosure::apply(Graph &graph) {
+    const DistanceMatrix *matrix = graph.getDistMatrix();
+    if (matrix == nullptr || matrix->getNumVertex() < 2) {
+        return false;
+    }
+    size_t entries = matrix->getNumEntries();
+    size_t missing = 0;
+    for (size_t k = 0; k < entries; k++) {
+        missing += matrix->entry(k) == 0;
+    }
+    if (missing == 0) {
+        return false;
+    }
+
+    const CompactGraph &adjacency = graph.getAdjacency();
+    int n = adjacency.getNumVertex();
+    vector<double> packed(entries, 0.0);
+    NextHopTable *next = nullptr;
+    if (NextHopTable::bytesFor(n) <= MAX_TABLE_BYTES) {
+        next = new NextHopTable(n);
+    }
+    double heapWork = (double) (adjacency.getNumEdges() + n) * log2((double) n);
+    if ((double) n * n <= heapWork) {
+        floydWarshall(adjacency, packed, next);
+    } else {
+        dijkstra(adjacency, packed, next);
+    }
+
+    bool connected = true;
+    for (size_t k = 0; k < entries && connected; k++) {
+        connected = packed[k] != 0;
+    }
+    graph.setMetricClosure(packed.data(), next, connected);
+    return true;
+}
+
+/**
+ * @brief Relaxes the pairs of one tile through the intermediate vertices of another.
+ *
+ * @param dist The full distance matrix, row-major.
+ * @param next The next hops, or nullptr.
+ * @param n The number of vertices.
+ * @param ib The row of the tile, in tiles.
+ * @param jb The column of the tile, in tiles.
+ * @param kb The tile of intermediate vertices.
+ */
+
+static void relaxTile(vector<double> &dist, NextHopTable *next, int n, int ib, int jb, int kb) {
+    const int B = MetricClosure::BLOCK;
+    int iEnd = min(n, (ib + 1) * B);
+    int jEnd = min(n, (jb + 1) * B);
+    int kEnd = min(n, (kb + 1) * B);
+    for (int k = kb * B; k < kEnd; k++) {
+        const double *rowK = &dist[(size_t) k * n];
+        for (int i = ib * B; i < iEnd; i++) {
+            double *rowI = &dist[(size_t) i * n];
+            double dik = rowI[k];
+            if (dik == UNREACHABLE) {
+                continue;
+            }
+            int hop = next != nullptr ? next->get(i, k) : -1;
+            for (int j = jb * B; j < jEnd; j++) {
+                double through = dik + rowK[j];
+                if (through < rowI[j]) {
+                    rowI[j] = through;
+                    if (next != nullptr) {
+                        next->set(i, j, hop);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Computes all shortest paths with a cache-blocked Floyd-Warshall.
+ *
+ * For each tile of intermediate vertices, the diagonal tile is closed first, then the tiles in its row and column,
+ * which only depend on it, and then every other tile, which only depends on the row and column. Tiles of the same
+ * phase are independent and run in parallel.
+ *
+ * @param adjacency The edges of the graph.
+ * @param packed Receives the n(n-1)/2 distances of the upper triangle, 0 for unreachable pairs.
+ * @param next Receives the next hop from each vertex towards each other vertex, or nullptr to skip them.
+ * @complexity O(|V|^3) time and O(|V|^2) memory, divided among the worker threads.
+ */
+
+void MetricClosure::floydWarshall(const CompactGraph &adjacency, vector<double> &packed, NextHopTable *next) {
+    int n = adjacency.getNumVertex();
+    vector<double> dist((size_t) n * n, UNREACHABLE);
+    for (int i = 0; i < n; i++) {
+        dist[(size_t) i * n + i] = 0;
+        if (next != nullptr) {
+            next->set(i, i, i);
+        }
+        for (CompactEdge edge : adjacency.neighbours(i)) {
+            double &d = dist[(size_t) i * n + edge.dest];
+            if (edge.dest != i && edge.weight < d) {
+                d = edge.weight;
+                if (next != nullptr) {
+                    next->set(i, edge.dest, edge.dest);
+                }
+            }
+        }
+    }
+
+    int tiles = (n + BLOCK - 1) / BLOCK;
+    for (int kb = 0; kb < tiles; kb++) {
+        relaxTile(dist, next, n, kb, kb, kb);
+        parallelFor(2 * (size_t) tiles, 1, [&](size_t begin, size_t end) {
+            for (size_t t = begin; t < end; t++) {
+                int other = (int) (t / 2);
+                if (other == kb) continue;
+                if (t % 2 == 0) {
+                    relaxTile(dist, next, n, kb, other, kb);
+                } else {
+                    relaxTile(dist, next, n, other, kb, kb);
+                }
+            }
+        });
+        parallelFor((size_t) tiles * tiles, 1, [&](size_t begin, size_t end) {
+            for (size_t t = begin; t < end; t++) {
+                int ib = (int) (t / tiles);
+                int jb = (int) (t % tiles);
+                if (ib == kb || jb == kb) continue;
+                relaxTile(dist, next, n, ib, jb, kb);
+            }
+        });
+    }
+
+    size_t k = 0;
+    for (int i = 0; i < n; i++) {
+        for (int j = i + 1; j < n; j++) {
+            double d = dist[(size_t) i * n + j];
+            packed[k++] = d == UNREACHABLE ? 0 : d;
+        }
+    }
+}
+
+/**
+ * @brief Computes all shortest paths with one Dijkstra per source, the sources spread over worker threads.
+ *
+ * The next hop from the source towards each vertex is inherited from its predecessor as vertices are settled.
+ * Each source only writes its own row of next hops and its own row of the triangle, so no locking is needed.
+ *
+ * @param adjacency The edges of the graph.
+ * @param packed Receives the n(n-1)/2 distances of the upper triangle, 0 for unreachable pairs.
+ * @param next Receives the next hop from each vertex towards each other vertex, or nullptr to skip them.
+ * @complexity O(|V| (|V| + |E|) log |V|) time, divided among the worker threads.
+ */
+
+void MetricClosure::dijkstra(const CompactGraph &adjacency, vector<double> &packed, NextHopTable *next) {
+    int n = adjacency.getNumVertex();
+    parallelFor(n, 8, [&](size_t begin, size_t end) {
+        vector<double> dist(n);
+        vector<uint8_t> settled(n);
+        vector<int> hop(n);
+        priority_queue<pair<double, int>, vector<pair<double, int>>, greater<>> queue;
+        for (int s = (int) begin; s < (int) end; s++) {
+            fill(dist.begin(), dist.end(), UNREACHABLE);
+            fill(settled.begin(), settled.end(), 0);
+            fill(hop.begin(), hop.end(), -1);
+            dist[s] = 0;
+            hop[s] = s;
+            queue.emplace(0.0, s);
+            while (!queue.empty()) {
+                int u = queue.top().second;
+                queue.pop();
+                if (settled[u]) continue;
+                settled[u] = 1;
+                for (CompactEdge edge : adjacency.neighbours(u)) {
+                    double d = dist[u] + edge.weight;
+                    if (d < dist[edge.dest]) {
+                        dist[edge.dest] = d;
+                        hop[edge.dest] = u == s ? edge.dest : hop[u];
+                        queue.emplace(d, edge.dest);
+                    }
+                }
+            }
+            size_t k = (size_t) s * (2 * (size_t) n - s - 1) / 2;
+            for (int t = s + 1; t < n; t++) {
+                packed[k++] = dist[t] == UNREACHABLE ? 0 : dist[t];
+            }
+            if (next != nullptr) {
+                for (int t = 0; t < n; t++) {
+                    next->set(s, t, hop[t]);
+                }
+            }
+        }
+    });
+}
@@ -0,0 +1,85 @@
+//
+// Created by oem on 12/06/23.
+//
+
+#ifndef DA___2ND_PROJECT_METRICCLOSURE_H
+#define DA___2ND_PROJECT_METRICCLOSURE_H
+
+#include <vector>
+#include "Graph.h"
+#include "NextHopTable.h"
+
+using namespace std;
+
+/**
+ * @brief The MetricClosure class replaces the distance matrix of an incomplete graph by its shortest paths.
+ *
+ * A distance matrix built from the edges holds 0 for pairs that are not adjacent, which the algorithms read as
+ * impassable: backtracking finds no tour and the triangle inequality the approximation relies on does not hold. The
+ * closure gives every connected pair the length of its shortest path instead, and records the next hop of that path
+ * in a NextHopTable so a tour can be expanded back into roads. Graphs whose table would exceed MAX_TABLE_BYTES keep
+ * no table; their tours are expanded by a RoadPath that searches each leg on demand.
+ *
+ * Dense graphs are closed with a cache-blocked Floyd-Warshall, sparse graphs with one Dijkstra per source; both run
+ * on every hardware thread.
+ */
+
+class MetricClosure {
+public:
+
+/**
+ * The side of the square tiles Floyd-Warshall works on; three tiles of doubles fit in a typical L2 cache.
+ */
+
+    static constexpr int BLOCK = 64;
+
+/**
+ * The most memory the next hops of a graph may take; larger graphs keep none.
+ */
+
+    static constexpr size_t MAX_TABLE_BYTES = (size_t) 128 << 20;
+
+/**
+ * @brief Reads whether the closure is wanted from the DA_CLOSURE environment variable.
+ *
+ * @return False for "off" or "0", true otherwise.
+ */
+
+    static bool enabled();
+
+/**
+ * @brief Replaces the distance matrix of a graph by its metric closure, if some pair of vertices is not adjacent.
+ *
+ * The matrix keeps its precision. Pairs in different components keep the distance 0 and the next hop -1.
+ *
+ * @param graph The graph, with a distance matrix.
+ * @return True if the matrix was replaced, false if the graph has no matrix or every pair is already adjacent.
+ */
+
+    static bool apply(Graph &graph);
+
+/**
+ * @brief Computes all shortest paths with a cache-blocked Floyd-Warshall.
+ *
+ * @param adjacency The edges of the graph.
+ * @param packed Receives the n(n-1)/2 distances of the upper triangle, 0 for unreachable pairs.
+ * @param next Receives the next hop from each vertex towards each other vertex, or nullptr to skip them.
+ * @complexity O(|V|^3) time and O(|V|^2) memory, divided among the worker threads.
+ */
+
+    static void floydWarshall(const CompactGraph &adjacency, vector<double> &packed, NextHopTable *next);
+
+/**
+ * @brief Computes all shortest paths with one Dijkstra per source, the sources spread over worker threads.
+ *
+ * @param adjacency The edges of the graph.
+ * @param packed Receives the n(n-1)/2 distances of the upper triangle, 0 for unreachable pairs.
+ * @param next Receives the next hop from each vertex towards each other vertex, or nullptr to skip them.
+ * @complexity O(|V| (|V| + |E|) log |V|) time, divided among the worker threads.
+ */
+
+    static void dijkstra(const CompactGraph &adjacency, vector<double> &packed, NextHopTable *next);
+};
+
+
+#endif //DA___2ND_PROJECT_METRICCLOSURE_H
@@ -0,0 +1,70 @@
+//
+// Created by oem on 12/06/23.
+//
+
+#include "NextHopTable.h"
+
+/**
+ * @brief Returns the memory a table would take.
+ *
+ * @param n The number of vertices.
+ * @return The number of bytes.
+ */
+
+size_t NextHopTable::bytesFor(int n) {
+    return (size_t) n * n * (n < NONE ? sizeof(uint16_t) : sizeof(int32_t));
+}
+
+/**
+ * @brief Constructs a table where no pair has a hop.
+ *
+ * @param n The number of vertices.
+ */
+
+NextHopTable::NextHopTable(int n) : n(n) {
+    if (n < NONE) {
+        narrow.assign((size_t) n * n, NONE);
+    } else {
+        wide.assign((size_t) n * n, -1);
+    }
+}
+
+/**
+ * @brief Returns the number of vertices.
+ *
+ * @return The number of vertices.
+ */
+
+int NextHopTable::getNumVertex() const {
+    return n;
+}
+
+/**
+ * @brief Returns the memory held by the table.
+ *
+ * @return The number of bytes.
+ */
+
+size_t NextHopTable::memoryUsage() const {
+    return narrow.size() * sizeof(uint16_t) + wide.size() * sizeof(int32_t);
+}
+
+/**
+ * @brief Returns the hops as one block, e.g. to write them to a file.
+ *
+ * @return A pointer to memoryUsage() bytes.
+ */
+
+const void *NextHopTable::data() const {
+    return narrow.empty() ? (const void *) wide.data() : (const void *) narrow.data();
+}
+
+/**
+ * @brief Returns the hops as one block, e.g. to read them from a file.
+ *
+ * @return A pointer to memoryUsage() bytes.
+ */
+
+void *NextHopTable::data() {
+    return narrow.empty() ? (void *) wide.data() : (void *) narrow.data();
+}
@@ -0,0 +1,117 @@
+//
+// Created by oem on 12/06/23.
+//
+
+#ifndef DA___2ND_PROJECT_NEXTHOPTABLE_H
+#define DA___2ND_PROJECT_NEXTHOPTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief The NextHopTable class stores, for every ordered pair of vertices, the next vertex on a shortest path.
+ *
+ * Graphs with fewer than 65535 vertices store each hop in 16 bits, half the memory of an int matrix; larger graphs
+ * fall back to 32 bits. The hops live in one row-major block.
+ */
+
+class NextHopTable {
+public:
+
+/**
+ * @brief Returns the memory a table would take.
+ *
+ * @param n The number of vertices.
+ * @return The number of bytes.
+ */
+
+    static size_t bytesFor(int n);
+
+/**
+ * @brief Constructs a table where no pair has a hop.
+ *
+ * @param n The number of vertices.
+ */
+
+    explicit NextHopTable(int n);
+
+/**
+ * @brief Returns the next vertex on the shortest path between two vertices.
+ *
+ * @param i The dense index of the vertex the path starts at.
+ * @param j The dense index of the vertex the path ends at.
+ * @return The dense index of the vertex after i, or -1 if there is no path.
+ */
+
+    int get(int i, int j) const {
+        size_t k = (size_t) i * n + j;
+        if (!narrow.empty()) {
+            return narrow[k] == NONE ? -1 : narrow[k];
+        }
+        return wide[k];
+    }
+
+/**
+ * @brief Stores the next vertex on the shortest path between two vertices.
+ *
+ * Different pairs may be stored from different threads at the same time.
+ *
+ * @param i The dense index of the vertex the path starts at.
+ * @param j The dense index of the vertex the path ends at.
+ * @param hop The dense index of the vertex after i, or -1 if there is no path.
+ */
+
+    void set(int i, int j, int hop) {
+        size_t k = (size_t) i * n + j;
+        if (!narrow.empty()) {
+            narrow[k] = hop < 0 ? NONE : (uint16_t) hop;
+        } else {
+            wide[k] = hop;
+        }
+    }
+
+/**
+ * @brief Returns the number of vertices.
+ *
+ * @return The number of vertices.
+ */
+
+    int getNumVertex() const;
+
+/**
+ * @brief Returns the memory held by the table.
+ *
+ * @return The number of bytes.
+ */
+
+    size_t memoryUsage() const;
+
+/**
+ * @brief Returns the hops as one block, e.g. to write them to a file.
+ *
+ * @return A pointer to memoryUsage() bytes.
+ */
+
+    const void *data() const;
+
+/**
+ * @brief Returns the hops as one block, e.g. to read them from a file.
+ *
+ * @return A pointer to memoryUsage() bytes.
+ */
+
+    void *data();
+
+private:
+    static constexpr uint16_t NONE = UINT16_MAX; /**< The 16-bit hop of pairs without a path */
+
+    int n; /**< Number of vertices */
+    vector<uint16_t> narrow; /**< The hops, if they fit in 16 bits */
+    vector<int32_t> wide; /**< The hops, otherwise */
+};
+
+
+#endif //DA___2ND_PROJECT_NEXTHOPTABLE_H
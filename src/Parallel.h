@@ -0,0 +1,64 @@
+//
+// Created by oem on 10/06/23.
+//
+
+#ifndef DA___2ND_PROJECT_PARALLEL_H
+#define DA___2ND_PROJECT_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Returns the number of worker threads used by parallelFor().
+ *
+ * @return The number of hardware threads, at least 1.
+ */
+
+inline unsigned workerCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * @brief Runs a function over the range [0, count) split into blocks handed out to worker threads.
+ *
+ * Blocks are claimed from a shared counter, so threads that get cheap blocks take more of them. Ranges of at most
+ * one block, and machines with one hardware thread, run on the calling thread.
+ *
+ * @tparam F A callable taking the first and one-past-the-last index of a block.
+ * @param count The number of indices.
+ * @param grain The number of indices per block.
+ * @param body The function run on every block. Different blocks may run at the same time.
+ */
+
+template <class F>
+void parallelFor(size_t count, size_t grain, const F &body) {
+    grain = std::max<size_t>(1, grain);
+    size_t blocks = (count + grain - 1) / grain;
+    unsigned workers = (unsigned) std::min<size_t>(workerCount(), blocks);
+    if (workers <= 1) {
+        if (count > 0) {
+            body((size_t) 0, count);
+        }
+        return;
+    }
+    std::atomic<size_t> next(0);
+    auto work = [&]() {
+        for (size_t block = next++; block < blocks; block = next++) {
+            size_t begin = block * grain;
+            body(begin, std::min(count, begin + grain));
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < workers; i++) {
+        pool.emplace_back(work);
+    }
+    work();
+    for (std::thread &t : pool) {
+        t.join();
+    }
+}
+
+#endif //DA___2ND_PROJECT_PARALLEL_H
@@ -0,0 +1,329 @@
+//
+// Created by oem on 15/06/23.
+//
+
+#include "ParallelBacktracking.h"
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+/**
+ * @brief Constructs a search over the vertices of an oracle.
+ *
+ * The dense matrix is filled one row at a time with DistanceOracle::row(), which copies a row of the distance matrix
+ * or computes it in O(n + degree) on lazy oracles, and the rows are split between the worker threads.
+ *
+ * @param distances The distances between the vertices, 0 for missing edges.
+ * @param root The dense index of the vertex every tour starts and ends at.
+ * @param threads The number of worker threads, the calling one included.
+ */
+
+ParallelBacktracking::ParallelBacktracking(const DistanceOracle &distances, int root, unsigned threads) :
+    n(distances.getNumVertex()),
+    root(root),
+    best(numeric_limits<double>::max()),
+    pending(0),
+    available(0),
+    idle(0),
+    stopped(false)
+{
+    if ((size_t) n * n * sizeof(double) <= MAX_MATRIX_BYTES) {
+        dist.resize((size_t) n * n);
+        parallelFor(n, 16, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                distances.row((int) i, dist.data() + i * n);
+            }
+        });
+    }
+    threads = max(1u, threads);
+    for (unsigned i = 0; i < threads; i++) {
+        workers.push_back(make_unique<Worker>());
+    }
+}
+
+/**
+ * @brief Searches for the shortest tour.
+ *
+ * @param path Receives the shortest tour, as dense indices starting at the root.
+ * @param timeLimit The most seconds to search, or 0 for no limit.
+ * @return The length of the shortest tour, or -1 if there is none, the search ran out of time or the matrix would
+ * exceed MAX_MATRIX_BYTES.
+ */
+
+double ParallelBacktracking::solve(int path[], double timeLimit) {
+    best = numeric_limits<double>::max();
+    recorded = numeric_limits<double>::max();
+    bestPath.clear();
+    stopped = false;
+    idle = 0;
+    stats.clear();
+    if (dist.empty()) {
+        return -1;
+    }
+    for (auto &worker : workers) {
+        worker->tasks.clear();
+        worker->path.assign(n, 0);
+        worker->cost.assign(n, 0);
+        worker->next.assign(n + 1, 0);
+        worker->visited.assign((n + 63) / 64, 0);
+        worker->stats = SearchStats();
+    }
+    limited = timeLimit > 0;
+    deadline = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(timeLimit));
+
+    pending = 1;
+    available = 1;
+    workers[0]->tasks.push_back({{root}, 0});
+    vector<thread> pool;
+    for (unsigned i = 1; i < workers.size(); i++) {
+        pool.emplace_back(&ParallelBacktracking::work, this, i);
+    }
+    work(0);
+    for (thread &t : pool) {
+        t.join();
+    }
+
+    for (auto &worker : workers) {
+        stats.push_back(worker->stats);
+    }
+    if (stopped || bestPath.empty()) {
+        return -1;
+    }
+    for (int i = 0; i < n; i++) {
+        path[i] = bestPath[i];
+    }
+    return recorded;
+}
+
+/**
+ * @brief Returns what every worker did during the last search.
+ *
+ * @return One entry per worker thread, the calling thread first.
+ */
+
+const vector<SearchStats> &ParallelBacktracking::getStats() const {
+    return stats;
+}
+
+/**
+ * @brief Checks if the last search went through the whole search tree.
+ *
+ * @return False if it ran out of time or the graph was too large to search, true otherwise.
+ */
+
+bool ParallelBacktracking::isFinished() const {
+    return !stopped && !dist.empty();
+}
+
+/**
+ * @brief Runs tasks on one worker until every task is finished or the time runs out.
+ *
+ * A task is finished only after the tasks it pushed were counted, so pending drops to 0 only when the whole tree was
+ * searched. A worker without tasks sleeps until a task is pushed, the search ends or the time runs out, instead of
+ * spinning over the deques of the others.
+ *
+ * @param id The index of the worker.
+ */
+
+void ParallelBacktracking::work(unsigned id) {
+    Worker &worker = *workers[id];
+    bool waiting = false;
+    while (!stopped.load(memory_order_relaxed)) {
+        Task task;
+        if (take(id, task)) {
+            if (waiting) {
+                idle--;
+                waiting = false;
+            }
+            auto begin = chrono::steady_clock::now();
+            run(worker, task);
+            worker.stats.seconds += chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+            worker.stats.tasks++;
+            if (--pending == 0) {
+                wakeAll();
+            }
+            continue;
+        }
+        if (pending.load() == 0) {
+            break;
+        }
+        if (!waiting) {
+            idle++;
+            waiting = true;
+        }
+        unique_lock<mutex> lock(idleLock);
+        wake.wait(lock, [this]() {
+            return available.load() > 0 || pending.load() == 0 || stopped.load();
+        });
+    }
+    if (waiting) {
+        idle--;
+    }
+}
+
+/**
+ * @brief Takes a task for a worker: its newest own task or, failing that, the oldest task of another worker.
+ *
+ * @param id The index of the worker.
+ * @param task Receives the task.
+ * @return False if every deque was empty.
+ */
+
+bool ParallelBacktracking::take(unsigned id, Task &task) {
+    Worker &own = *workers[id];
+    {
+        lock_guard<mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = move(own.tasks.back());
+            own.tasks.pop_back();
+            available--;
+            return true;
+        }
+    }
+    for (size_t i = 1; i < workers.size() && available.load() > 0; i++) {
+        Worker &victim = *workers[(id + i) % workers.size()];
+        lock_guard<mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = move(victim.tasks.front());
+            victim.tasks.pop_front();
+            available--;
+            own.stats.steals++;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Searches the completions of the path of a task.
+ *
+ * @param worker The worker running the task.
+ * @param task The task.
+ */
+
+void ParallelBacktracking::run(Worker &worker, const Task &task) {
+    int depth = (int) task.path.size();
+    for (int i = 0; i < depth; i++) {
+        worker.path[i] = task.path[i];
+        toggleVisited(worker, task.path[i]);
+    }
+    worker.cost[depth - 1] = task.cost;
+    search(worker, depth);
+    fill(worker.visited.begin(), worker.visited.end(), 0);
+}
+
+/**
+ * @brief Searches the completions of the path of a worker.
+ *
+ * The path is extended and shortened in place, next[d] remembering where the children of the vertex at depth d - 1
+ * resume. While another worker waits for a task, the children of nodes far from the leaves are pushed to the deque of
+ * the worker instead of being searched, for the waiting workers to steal.
+ *
+ * @param worker The worker, whose path, cost and visited hold the path.
+ * @param base The number of vertices of the path.
+ * @note O(n!) in the worst case.
+ */
+
+void ParallelBacktracking::search(Worker &worker, int base) {
+    int *path = worker.path.data();
+    double *cost = worker.cost.data();
+    int *next = worker.next.data();
+    size_t nodes = 1;
+    int depth = base;
+    next[depth] = 0;
+    while (true) {
+        int last = path[depth - 1];
+        const double *row = dist.data() + (size_t) last * n;
+        if (depth == n) {
+            if (row[root] != 0) {
+                record(worker.path, cost[depth - 1] + row[root]);
+            }
+        }
+        else if (next[depth] == 0 && n - depth >= SPLIT_MIN_REMAINING && idle.load(memory_order_relaxed) > 0) {
+            double bound = best.load(memory_order_relaxed);
+            bool pushed = false;
+            for (int i = 0; i < n; i++) {
+                if (row[i] > 0 && !isVisited(worker, i) && cost[depth - 1] + row[i] < bound) {
+                    Task task{vector<int>(path, path + depth), cost[depth - 1] + row[i]};
+                    task.path.push_back(i);
+                    pending++;
+                    lock_guard<mutex> guard(worker.lock);
+                    worker.tasks.push_back(move(task));
+                    available++;
+                    pushed = true;
+                }
+            }
+            if (pushed) {
+                wakeAll();
+            }
+        }
+        else {
+            double bound = best.load(memory_order_relaxed);
+            int i = next[depth];
+            while (i < n && !(row[i] > 0 && !isVisited(worker, i) && cost[depth - 1] + row[i] < bound)) {
+                i++;
+            }
+            if (i < n) {
+                next[depth] = i + 1;
+                path[depth] = i;
+                cost[depth] = cost[depth - 1] + row[i];
+                toggleVisited(worker, i);
+                next[++depth] = 0;
+                if (++nodes % CHECK_INTERVAL == 0) {
+                    if (limited && chrono::steady_clock::now() > deadline) {
+                        stopped = true;
+                        wakeAll();
+                    }
+                    if (stopped.load(memory_order_relaxed)) {
+                        break;
+                    }
+                }
+                continue;
+            }
+        }
+        // Every child of the node was searched: go back to its parent
+        if (--depth < base) {
+            break;
+        }
+        toggleVisited(worker, path[depth]);
+    }
+    worker.stats.nodes += nodes;
+}
+
+/**
+ * @brief Wakes every sleeping worker to check for tasks, the end of the search or the stop flag again.
+ *
+ * The lock is taken between the change the workers wait for and the notification, so a worker about to sleep either
+ * sees the change or gets the notification.
+ */
+
+void ParallelBacktracking::wakeAll() {
+    {
+        lock_guard<mutex> guard(idleLock);
+    }
+    wake.notify_all();
+}
+
+/**
+ * @brief Records a tour if it is shorter than the best one, and lowers the shared bound.
+ *
+ * Two workers may lower the bound in one order and take the lock in the other, so the tour is kept only if it is
+ * still shorter than the recorded one.
+ *
+ * @param path The tour, all n vertices of it.
+ * @param cost The length of the tour, including the edge back to the root.
+ */
+
+void ParallelBacktracking::record(const vector<int> &path, double cost) {
+    double current = best.load();
+    while (cost < current && !best.compare_exchange_weak(current, cost)) {
+    }
+    if (cost >= current) {
+        return;
+    }
+    lock_guard<mutex> guard(bestLock);
+    if (cost < recorded) {
+        recorded = cost;
+        bestPath = path;
+    }
+}
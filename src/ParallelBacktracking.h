@@ -0,0 +1,226 @@
+//
+// Created by oem on 15/06/23.
+//
+
+#ifndef DA___2ND_PROJECT_PARALLELBACKTRACKING_H
+#define DA___2ND_PROJECT_PARALLELBACKTRACKING_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "DistanceOracle.h"
+#include "Parallel.h"
+
+using namespace std;
+
+/**
+ * @brief The SearchStats struct holds what one worker thread of a parallel search did.
+ */
+
+struct SearchStats {
+    size_t nodes = 0; /**< Nodes of the search tree the worker visited */
+    size_t tasks = 0; /**< Tasks the worker ran */
+    size_t steals = 0; /**< Tasks the worker took from the deque of another worker */
+    double seconds = 0; /**< Wall time the worker spent running tasks */
+};
+
+/**
+ * @brief The ParallelBacktracking class finds the shortest tour by backtracking over every path from the start, on
+ * several threads.
+ *
+ * The search is the one of Services::BT: paths are extended in index order and dropped as soon as they are as long
+ * as the best tour found. A task is a path to search below. Every worker keeps its tasks in its own deque, runs the
+ * newest one and, when it has none, steals the oldest one of another worker, which is the one closest to the start
+ * and so the largest. While some worker is waiting, a worker at a node far enough from the leaves pushes the children
+ * of the node as tasks instead of searching them itself, so the search tree is split where work is missing.
+ *
+ * The length of the best tour is shared through an atomic, so a tour found by one worker prunes the others at once.
+ * With one thread no task is ever split and the search is exactly the serial one.
+ *
+ * Below a task the search allocates nothing: it walks an explicit stack of per-depth arrays sized once per worker,
+ * keeps the visited vertices in a bitset and reads the distances from one row of a dense matrix per node. The clock
+ * and the stop flag are only read every CHECK_INTERVAL expansions.
+ */
+
+class ParallelBacktracking {
+public:
+
+/**
+ * The fewest vertices a path must still miss for its children to be pushed as tasks; smaller subtrees are cheaper to
+ * search than to hand over.
+ */
+
+    static constexpr int SPLIT_MIN_REMAINING = 6;
+
+/**
+ * The most memory the dense distance matrix may take, about 5800 vertices; larger graphs are not searched.
+ */
+
+    static constexpr size_t MAX_MATRIX_BYTES = (size_t) 256 << 20;
+
+/**
+ * @brief Constructs a search over the vertices of an oracle.
+ *
+ * @param distances The distances between the vertices, 0 for missing edges.
+ * @param root The dense index of the vertex every tour starts and ends at.
+ * @param threads The number of worker threads, the calling one included.
+ */
+
+    ParallelBacktracking(const DistanceOracle &distances, int root, unsigned threads = workerCount());
+
+/**
+ * @brief Searches for the shortest tour.
+ *
+ * @param path Receives the shortest tour, as dense indices starting at the root.
+ * @param timeLimit The most seconds to search, or 0 for no limit.
+ * @return The length of the shortest tour, or -1 if there is none, the search ran out of time or the matrix would
+ * exceed MAX_MATRIX_BYTES.
+ */
+
+    double solve(int path[], double timeLimit = 0);
+
+/**
+ * @brief Returns what every worker did during the last search.
+ *
+ * @return One entry per worker thread, the calling thread first.
+ */
+
+    const vector<SearchStats> &getStats() const;
+
+/**
+ * @brief Checks if the last search went through the whole search tree.
+ *
+ * @return False if it ran out of time or the graph was too large to search, true otherwise.
+ */
+
+    bool isFinished() const;
+
+private:
+
+/**
+ * @brief A path whose completions are still to be searched.
+ */
+
+    struct Task {
+        vector<int> path; /**< The vertices of the path, from the root */
+        double cost; /**< The length of the path */
+    };
+
+/**
+ * @brief The state of one worker thread.
+ */
+
+    struct Worker {
+        mutex lock; /**< Guards tasks */
+        deque<Task> tasks; /**< Tasks to run; the owner takes from the back, thieves from the front */
+        vector<int> path; /**< The path being searched */
+        vector<double> cost; /**< The length of the first i + 1 vertices of the path, at i */
+        vector<int> next; /**< The next vertex to try at each depth of the path */
+        vector<uint64_t> visited; /**< The vertices on the path, as a bitset */
+        SearchStats stats; /**< What the worker did */
+    };
+
+    static constexpr size_t CHECK_INTERVAL = 4096; /**< Expansions between two reads of the clock and the stop flag */
+
+    int n; /**< Number of vertices */
+    int root; /**< The vertex every tour starts and ends at */
+    vector<double> dist; /**< The n x n distances, 0 for missing edges; empty past MAX_MATRIX_BYTES */
+    vector<unique_ptr<Worker>> workers; /**< The workers, the calling thread first */
+    vector<SearchStats> stats; /**< What every worker did during the last search */
+    atomic<double> best; /**< The length of the shortest tour found, shared by every worker */
+    mutex bestLock; /**< Guards recorded and bestPath */
+    double recorded = 0; /**< The length of bestPath */
+    vector<int> bestPath; /**< The shortest tour found */
+    atomic<size_t> pending; /**< Tasks pushed and not yet finished */
+    atomic<size_t> available; /**< Tasks pushed and not yet taken */
+    atomic<unsigned> idle; /**< Workers waiting for a task */
+    mutex idleLock; /**< Guards the sleep of idle workers */
+    condition_variable wake; /**< Wakes idle workers when a task is pushed or the search ends */
+    atomic<bool> stopped; /**< Whether the search ran out of time */
+    chrono::steady_clock::time_point deadline; /**< When the search stops, if limited */
+    bool limited = false; /**< Whether the search has a deadline */
+
+/**
+ * @brief Runs tasks on one worker until every task is finished or the time runs out.
+ *
+ * @param id The index of the worker.
+ */
+
+    void work(unsigned id);
+
+/**
+ * @brief Takes a task for a worker: its newest own task or, failing that, the oldest task of another worker.
+ *
+ * @param id The index of the worker.
+ * @param task Receives the task.
+ * @return False if every deque was empty.
+ */
+
+    bool take(unsigned id, Task &task);
+
+/**
+ * @brief Searches the completions of the path of a task.
+ *
+ * @param worker The worker running the task.
+ * @param task The task.
+ */
+
+    void run(Worker &worker, const Task &task);
+
+/**
+ * @brief Searches the completions of the path of a worker.
+ *
+ * @param worker The worker, whose path, cost and visited hold the path.
+ * @param base The number of vertices of the path.
+ * @complexity O(n!) in the worst case.
+ */
+
+    void search(Worker &worker, int base);
+
+/**
+ * @brief Checks if a vertex is on the path of a worker.
+ *
+ * @param worker The worker.
+ * @param v The dense index of the vertex.
+ * @return True if it was visited.
+ */
+
+    static bool isVisited(const Worker &worker, int v) {
+        return worker.visited[v >> 6] >> (v & 63) & 1;
+    }
+
+/**
+ * @brief Adds a vertex to the visited set of a worker, or removes it.
+ *
+ * @param worker The worker.
+ * @param v The dense index of the vertex.
+ */
+
+    static void toggleVisited(Worker &worker, int v) {
+        worker.visited[v >> 6] ^= (uint64_t) 1 << (v & 63);
+    }
+
+/**
+ * @brief Wakes every sleeping worker to check for tasks, the end of the search or the stop flag again.
+ */
+
+    void wakeAll();
+
+/**
+ * @brief Records a tour if it is shorter than the best one, and lowers the shared bound.
+ *
+ * @param path The tour, all n vertices of it.
+ * @param cost The length of the tour, including the edge back to the root.
+ */
+
+    void record(const vector<int> &path, double cost);
+};
+
+
+#endif //DA___2ND_PROJECT_PARALLELBACKTRACKING_H
@@ -0,0 +1,211 @@
+//
+// Created by oem on 13/06/23.
+//
+
+#include "Renumbering.h"
+#include <algorithm>
+#include <cstdlib>
+
+/**
+ * @brief Reads the wanted order from the DA_REORDER environment variable.
+ *
+ * @return HILBERT for "hilbert", RCM for "rcm", AUTO for "auto" or "on", NONE otherwise.
+ */
+
+Renumbering::Strategy Renumbering::fromEnvironment() {
+    const char *value = getenv("DA_REORDER");
+    if (value == nullptr) return NONE;
+    string name(value);
+    if (name == "hilbert") return HILBERT;
+    if (name == "rcm") return RCM;
+    if (name == "auto" || name == "on") return AUTO;
+    return NONE;
+}
+
+/**
+ * @brief Returns the name of a strategy, for output.
+ *
+ * @param strategy The strategy.
+ * @return The name.
+ */
+
+string Renumbering::name(Strategy strategy) {
+    switch (strategy) {
+        case HILBERT: return "Hilbert curve";
+        case RCM: return "reverse Cuthill-McKee";
+        case AUTO: return "automatic";
+        default: return "dataset order";
+    }
+}
+
+/**
+ * @brief Computes an order of the vertices of a graph.
+ *
+ * @param graph The graph, with its adjacency built.
+ * @param strategy The order wanted. HILBERT falls back to RCM for graphs without coordinates.
+ * @return The old dense index of the vertex at every new dense index, empty for NONE.
+ */
+
+vector<int> Renumbering::order(const Graph &graph, Strategy strategy) {
+    if (strategy == NONE) {
+        return {};
+    }
+    if (strategy != RCM && graph.hasCoordinates()) {
+        return hilbert(graph);
+    }
+    return reverseCuthillMcKee(graph.getAdjacency());
+}
+
+/**
+ * @brief Orders the vertices along a Hilbert curve over their coordinates.
+ *
+ * The bounding box of the coordinates is stretched over the grid of the curve, so vertices close on the map get
+ * close positions along it.
+ *
+ * @param graph The graph, with coordinates.
+ * @return The old dense index of the vertex at every new dense index.
+ * @complexity O(|V| log |V|)
+ */
+
+vector<int> Renumbering::hilbert(const Graph &graph) {
+    int n = graph.getNumVertex();
+    vector<int> order(n);
+    if (n == 0) {
+        return order;
+    }
+    double minLon = graph.vertexAt(0)->getLongitude(), maxLon = minLon;
+    double minLat = graph.vertexAt(0)->getLatitude(), maxLat = minLat;
+    for (int i = 1; i < n; i++) {
+        minLon = min(minLon, graph.vertexAt(i)->getLongitude());
+        maxLon = max(maxLon, graph.vertexAt(i)->getLongitude());
+        minLat = min(minLat, graph.vertexAt(i)->getLatitude());
+        maxLat = max(maxLat, graph.vertexAt(i)->getLatitude());
+    }
+    double scaleLon = maxLon > minLon ? 65535.0 / (maxLon - minLon) : 0;
+    double scaleLat = maxLat > minLat ? 65535.0 / (maxLat - minLat) : 0;
+
+    vector<pair<uint64_t, int>> keys(n);
+    for (int i = 0; i < n; i++) {
+        auto x = (uint32_t) ((graph.vertexAt(i)->getLongitude() - minLon) * scaleLon);
+        auto y = (uint32_t) ((graph.vertexAt(i)->getLatitude() - minLat) * scaleLat);
+        keys[i] = {hilbertIndex(x, y), i};
+    }
+    sort(keys.begin(), keys.end());
+    for (int i = 0; i < n; i++) {
+        order[i] = keys[i].second;
+    }
+    return order;
+}
+
+/**
+ * @brief Orders the vertices by reverse Cuthill-McKee.
+ *
+ * Components are started from their vertex of least degree, which a few sweeps move to the far end of the component
+ * (a pseudo-peripheral vertex), so the levels of the search, and the bandwidth of the order, stay narrow.
+ *
+ * @param adjacency The adjacency of the graph.
+ * @return The old dense index of the vertex at every new dense index.
+ * @complexity O(|V| log |V| + |E| log Δ)
+ */
+
+vector<int> Renumbering::reverseCuthillMcKee(const CompactGraph &adjacency) {
+    int n = adjacency.getNumVertex();
+    vector<int> byDegree(n);
+    for (int i = 0; i < n; i++) {
+        byDegree[i] = i;
+    }
+    stable_sort(byDegree.begin(), byDegree.end(), [&adjacency](int a, int b) {
+        return adjacency.getDegree(a) < adjacency.getDegree(b);
+    });
+
+    vector<int> level(n, -1);
+    vector<int> order;
+    order.reserve(n);
+    vector<int> sweep;
+    for (int start : byDegree) {
+        if (level[start] != -1) {
+            continue;
+        }
+        // Move the start to the last level of a search from it while that makes the component deeper
+        int depth = -1;
+        for (int tries = 0; tries < 4; tries++) {
+            sweep.clear();
+            search(adjacency, start, level, sweep);
+            int last = level[sweep.back()];
+            int next = sweep.back();
+            for (auto it = sweep.rbegin(); it != sweep.rend() && level[*it] == last; ++it) {
+                if (adjacency.getDegree(*it) < adjacency.getDegree(next)) {
+                    next = *it;
+                }
+            }
+            for (int v : sweep) {
+                level[v] = -1;
+            }
+            if (last <= depth) {
+                break;
+            }
+            depth = last;
+            start = next;
+        }
+        search(adjacency, start, level, order);
+    }
+    reverse(order.begin(), order.end());
+    return order;
+}
+
+/**
+ * @brief Returns the position of a point along a Hilbert curve filling a 65536 x 65536 grid.
+ *
+ * @param x The column of the point.
+ * @param y The row of the point.
+ * @return The number of cells the curve visits before the point.
+ */
+
+uint64_t Renumbering::hilbertIndex(uint32_t x, uint32_t y) {
+    const uint32_t side = 1u << 16;
+    uint64_t d = 0;
+    for (uint32_t s = side / 2; s > 0; s /= 2) {
+        uint32_t rx = (x & s) > 0;
+        uint32_t ry = (y & s) > 0;
+        d += (uint64_t) s * s * ((3 * rx) ^ ry);
+        // Rotate the quadrant so the curve inside it has the orientation of the whole curve
+        if (ry == 0) {
+            if (rx == 1) {
+                x = side - 1 - x;
+                y = side - 1 - y;
+            }
+            swap(x, y);
+        }
+    }
+    return d;
+}
+
+/**
+ * @brief Searches a component breadth-first, visiting the neighbours of each vertex by increasing degree.
+ *
+ * @param adjacency The adjacency of the graph.
+ * @param start The vertex the search starts at.
+ * @param level Receives the distance in edges of every reached vertex from start; must hold -1 for unreached ones.
+ * @param order Receives the reached vertices in the order they were visited.
+ */
+
+void Renumbering::search(const CompactGraph &adjacency, int start, vector<int> &level, vector<int> &order) {
+    size_t head = order.size();
+    level[start] = 0;
+    order.push_back(start);
+    vector<int> children;
+    while (head < order.size()) {
+        int u = order[head++];
+        children.clear();
+        for (CompactEdge edge : adjacency.neighbours(u)) {
+            if (level[edge.dest] == -1) {
+                level[edge.dest] = level[u] + 1;
+                children.push_back(edge.dest);
+            }
+        }
+        stable_sort(children.begin(), children.end(), [&adjacency](int a, int b) {
+            return adjacency.getDegree(a) < adjacency.getDegree(b);
+        });
+        order.insert(order.end(), children.begin(), children.end());
+    }
+}
@@ -0,0 +1,113 @@
+//
+// Created by oem on 13/06/23.
+//
+
+#ifndef DA___2ND_PROJECT_RENUMBERING_H
+#define DA___2ND_PROJECT_RENUMBERING_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Graph.h"
+
+using namespace std;
+
+/**
+ * @brief The Renumbering class computes orders of the vertices that keep neighbours close in memory.
+ *
+ * Datasets list their vertices in arbitrary order, so the rows of the distance matrix and adjacency of nearby vertices
+ * end up far apart. Sorting vertices along a Hilbert curve over their coordinates, or by reverse Cuthill-McKee over
+ * the edges of graphs without coordinates, gives nearby vertices nearby dense indices. Graph::renumber() applies an
+ * order; results keep being printed through Graph::idOf(), so they still show the dataset IDs.
+ */
+
+class Renumbering {
+public:
+
+/**
+ * @brief The orders a graph can be renumbered in.
+ */
+
+    enum Strategy {
+        NONE, /**< Keep the order of the dataset */
+        HILBERT, /**< Along a Hilbert curve over the coordinates */
+        RCM, /**< Reverse Cuthill-McKee over the edges */
+        AUTO /**< HILBERT for graphs with coordinates, RCM otherwise */
+    };
+
+/**
+ * @brief Reads the wanted order from the DA_REORDER environment variable.
+ *
+ * @return HILBERT for "hilbert", RCM for "rcm", AUTO for "auto" or "on", NONE otherwise.
+ */
+
+    static Strategy fromEnvironment();
+
+/**
+ * @brief Returns the name of a strategy, for output.
+ *
+ * @param strategy The strategy.
+ * @return The name.
+ */
+
+    static string name(Strategy strategy);
+
+/**
+ * @brief Computes an order of the vertices of a graph.
+ *
+ * @param graph The graph, with its adjacency built.
+ * @param strategy The order wanted. HILBERT falls back to RCM for graphs without coordinates.
+ * @return The old dense index of the vertex at every new dense index, empty for NONE.
+ */
+
+    static vector<int> order(const Graph &graph, Strategy strategy);
+
+/**
+ * @brief Orders the vertices along a Hilbert curve over their coordinates.
+ *
+ * @param graph The graph, with coordinates.
+ * @return The old dense index of the vertex at every new dense index.
+ * @complexity O(|V| log |V|)
+ */
+
+    static vector<int> hilbert(const Graph &graph);
+
+/**
+ * @brief Orders the vertices by reverse Cuthill-McKee.
+ *
+ * Every connected component is searched breadth-first from a pseudo-peripheral vertex, visiting the neighbours of
+ * each vertex by increasing degree, and the whole order is reversed.
+ *
+ * @param adjacency The adjacency of the graph.
+ * @return The old dense index of the vertex at every new dense index.
+ * @complexity O(|V| log |V| + |E| log Δ)
+ */
+
+    static vector<int> reverseCuthillMcKee(const CompactGraph &adjacency);
+
+/**
+ * @brief Returns the position of a point along a Hilbert curve filling a 65536 x 65536 grid.
+ *
+ * @param x The column of the point.
+ * @param y The row of the point.
+ * @return The number of cells the curve visits before the point.
+ */
+
+    static uint64_t hilbertIndex(uint32_t x, uint32_t y);
+
+private:
+
+/**
+ * @brief Searches a component breadth-first, visiting the neighbours of each vertex by increasing degree.
+ *
+ * @param adjacency The adjacency of the graph.
+ * @param start The vertex the search starts at.
+ * @param level Receives the distance in edges of every reached vertex from start; must hold -1 for unreached ones.
+ * @param order Receives the reached vertices in the order they were visited.
+ */
+
+    static void search(const CompactGraph &adjacency, int start, vector<int> &level, vector<int> &order);
+};
+
+
+#endif //DA___2ND_PROJECT_RENUMBERING_H
@@ -0,0 +1,158 @@
+//
+// Created by oem on 12/06/23.
+//
+
+#include "RoadPath.h"
+#include <cstdint>
+#include <limits>
+#include <queue>
+
+/**
+ * @brief Constructs an iterator at the first step of a path, or at its end.
+ *
+ * @param path The path, or nullptr for the end iterator.
+ */
+
+RoadPath::iterator::iterator(RoadPath *path) : path(path) {
+    if (path == nullptr) {
+        return;
+    }
+    if (path->length < 2) {
+        this->path = nullptr;
+        return;
+    }
+    leg = -1;
+    step.to = path->tour[0];
+    advance();
+}
+
+/**
+ * @brief Moves to the next step, starting the next leg when the current one is done.
+ */
+
+void RoadPath::iterator::advance() {
+    int at = step.to;
+    int to = path->tour[(leg + 1) % path->length];
+    while (at == to) {
+        if (++leg == path->length) {
+            path = nullptr;
+            leg = 0;
+            step = {-1, -1, 0};
+            return;
+        }
+        to = path->tour[(leg + 1) % path->length];
+    }
+    step = path->stepFrom(at, to);
+}
+
+/**
+ * @brief Constructs the road path of a tour. The graph and the tour must outlive the path.
+ *
+ * @param graph The graph the tour was computed on.
+ * @param tour The dense indices of the visited vertices, in order.
+ * @param length The number of vertices in the tour.
+ */
+
+RoadPath::RoadPath(const Graph &graph, const int *tour, int length) :
+    graph(graph),
+    tour(tour),
+    length(length),
+    oracle(graph)
+    {}
+
+/**
+ * @brief Returns an iterator to the first step. Only one iteration may be in progress at a time.
+ *
+ * @return The iterator.
+ */
+
+RoadPath::iterator RoadPath::begin() {
+    return iterator(this);
+}
+
+/**
+ * @brief Returns the iterator past the last step.
+ *
+ * @return The iterator.
+ */
+
+RoadPath::iterator RoadPath::end() {
+    return iterator(nullptr);
+}
+
+/**
+ * @brief Returns the next vertex on the shortest path between two vertices.
+ *
+ * @param from The dense index of the current vertex.
+ * @param to The dense index of the end of the leg.
+ * @return The dense index of the next vertex, or -1 if there is no road.
+ */
+
+int RoadPath::nextHop(int from, int to) {
+    if (graph.getNextHops() != nullptr) {
+        return graph.getNextHops()->get(from, to);
+    }
+    if (to != target) {
+        search(to);
+    }
+    return towards[from];
+}
+
+/**
+ * @brief Computes the next hop of every vertex towards a vertex with Dijkstra's algorithm.
+ *
+ * The edges are undirected, so the tree of shortest paths from the vertex gives every other vertex its parent as the
+ * next hop back to it.
+ *
+ * @param to The dense index of the vertex.
+ * @complexity O((|V| + |E|) log |V|)
+ */
+
+void RoadPath::search(int to) {
+    const CompactGraph &adjacency = graph.getAdjacency();
+    int n = adjacency.getNumVertex();
+    vector<double> dist(n, numeric_limits<double>::infinity());
+    vector<uint8_t> settled(n, 0);
+    towards.assign(n, -1);
+    priority_queue<pair<double, int>, vector<pair<double, int>>, greater<>> queue;
+    dist[to] = 0;
+    towards[to] = to;
+    queue.emplace(0.0, to);
+    while (!queue.empty()) {
+        int u = queue.top().second;
+        queue.pop();
+        if (settled[u]) continue;
+        settled[u] = 1;
+        for (CompactEdge edge : adjacency.neighbours(u)) {
+            double d = dist[u] + edge.weight;
+            if (d < dist[edge.dest]) {
+                dist[edge.dest] = d;
+                towards[edge.dest] = u;
+                queue.emplace(d, edge.dest);
+            }
+        }
+    }
+    target = to;
+}
+
+/**
+ * @brief Returns the step from a vertex towards the end of a leg.
+ *
+ * @param from The dense index of the current vertex.
+ * @param to The dense index of the end of the leg.
+ * @return The edge to the next hop, or the whole leg if there is no road.
+ */
+
+RoadStep RoadPath::stepFrom(int from, int to) {
+    int hop = nextHop(from, to);
+    if (hop < 0) {
+        return {from, to, oracle(from, to)};
+    }
+    double weight = numeric_limits<double>::infinity();
+    for (CompactEdge edge : graph.getAdjacency().neighbours(from)) {
+        if (edge.dest == hop && edge.weight < weight) {
+            weight = edge.weight;
+        }
+    }
+    return {from, hop, weight};
+}
@@ -0,0 +1,135 @@
+//
+// Created by oem on 12/06/23.
+//
+
+#ifndef DA___2ND_PROJECT_ROADPATH_H
+#define DA___2ND_PROJECT_ROADPATH_H
+
+#include <cstddef>
+#include <vector>
+#include "Graph.h"
+#include "DistanceOracle.h"
+
+using namespace std;
+
+/**
+ * @brief One edge of a road path.
+ */
+
+struct RoadStep {
+    int from; /**< Dense index of the vertex the step leaves */
+    int to; /**< Dense index of the vertex the step reaches */
+    double weight; /**< The weight of the edge, or the distance of the leg if it has no road */
+};
+
+/**
+ * @brief The RoadPath class expands a tour over the metric closure back into the edges it travels.
+ *
+ * Every leg of the tour, including the one back to the start, is followed hop by hop while it is iterated, so nothing
+ * proportional to the length of the expanded path is stored. Hops are read from the graph's NextHopTable; graphs too
+ * large to keep one get them from a shortest-path tree towards the end of the current leg, searched when the leg
+ * starts, so the memory stays O(|V|). Legs with no road between their ends are yielded as a single step.
+ */
+
+class RoadPath {
+public:
+
+/**
+ * @brief Iterates the steps of a road path.
+ */
+
+    class iterator {
+    public:
+
+/**
+ * @brief Constructs an iterator at the first step of a path, or at its end.
+ *
+ * @param path The path, or nullptr for the end iterator.
+ */
+
+        explicit iterator(RoadPath *path);
+
+        const RoadStep &operator*() const { return step; }
+        const RoadStep *operator->() const { return &step; }
+        iterator &operator++() { advance(); return *this; }
+        bool operator==(const iterator &other) const { return path == other.path && leg == other.leg && step.from == other.step.from; }
+        bool operator!=(const iterator &other) const { return !(*this == other); }
+
+    private:
+        RoadPath *path; /**< The path, nullptr once every leg was walked */
+        int leg = 0; /**< Index in the tour of the vertex the current leg starts at */
+        RoadStep step{-1, -1, 0}; /**< The current step */
+
+/**
+ * @brief Moves to the next step, starting the next leg when the current one is done.
+ */
+
+        void advance();
+    };
+
+/**
+ * @brief Constructs the road path of a tour. The graph and the tour must outlive the path.
+ *
+ * @param graph The graph the tour was computed on.
+ * @param tour The dense indices of the visited vertices, in order.
+ * @param length The number of vertices in the tour.
+ */
+
+    RoadPath(const Graph &graph, const int *tour, int length);
+
+/**
+ * @brief Returns an iterator to the first step. Only one iteration may be in progress at a time.
+ *
+ * @return The iterator.
+ */
+
+    iterator begin();
+
+/**
+ * @brief Returns the iterator past the last step.
+ *
+ * @return The iterator.
+ */
+
+    iterator end();
+
+private:
+    const Graph &graph; /**< The graph the tour was computed on */
+    const int *tour; /**< The visited vertices */
+    int length; /**< The number of vertices in the tour */
+    DistanceOracle oracle; /**< The distances of legs with no road */
+    int target = -1; /**< The vertex the hops in towards lead to, -1 if none was searched */
+    vector<int> towards; /**< The next hop of every vertex towards target, only without a NextHopTable */
+
+/**
+ * @brief Returns the next vertex on the shortest path between two vertices.
+ *
+ * @param from The dense index of the current vertex.
+ * @param to The dense index of the end of the leg.
+ * @return The dense index of the next vertex, or -1 if there is no road.
+ */
+
+    int nextHop(int from, int to);
+
+/**
+ * @brief Computes the next hop of every vertex towards a vertex with Dijkstra's algorithm.
+ *
+ * @param to The dense index of the vertex.
+ * @complexity O((|V| + |E|) log |V|)
+ */
+
+    void search(int to);
+
+/**
+ * @brief Returns the step from a vertex towards the end of a leg.
+ *
+ * @param from The dense index of the current vertex.
+ * @param to The dense index of the end of the leg.
+ * @return The edge to the next hop, or the whole leg if there is no road.
+ */
+
+    RoadStep stepFrom(int from, int to);
+};
+
+
+#endif //DA___2ND_PROJECT_ROADPATH_H
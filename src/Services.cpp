@@ -3,70 +3,246 @@
 //
 
 #include "Services.h"
+#include "Parallel.h"
 int c=0;
 
 /**
  * Calculates the shortest path using the Backtracking algorithm in a given graph.
  *
+ * The search tree is split between every hardware thread with work stealing, and they all prune against the best
+ * tour found by any of them; see ParallelBacktracking.
+ *
  * @brief Calculates the shortest path using the Backtracking algorithm.
  * @param graph The graph object representing the vertices and edges.
- * @param path An array to store the shortest path found.
- * @return The minimum distance of the shortest path.
+ * @param path An array to store the shortest path found, as dense indices.
+ * @return The minimum distance of the shortest path, or -1 if there is none or the search takes longer than
+ * BT_TIME_LIMIT seconds.
  * @note This function has an exponential time complexity of O(2^n).
  */
 
-double Services::BT(Graph &graph, int path[]) {
-    int curPath[10000];
-    double minDist  = numeric_limits<double>::max();
+double Services::BT(const Graph &graph, int path[]) {
+    setDistances(graph);
+    ParallelBacktracking search(distances, graph.getStartIndex());
+    double minDist = search.solve(path, BT_TIME_LIMIT);
+    searchStats = search.getStats();
+    size_t nodes = 0;
+    for (const SearchStats &stats : searchStats) {
+        nodes += stats.nodes;
+    }
+    LOG(Logger::INFO, "Backtracking visited " << nodes << " nodes on " << searchStats.size() << " threads");
+    return minDist;
+}
 
-    curPath[0] = 0;
-    start = chrono::high_resolution_clock::now();
-    BTRec(graph, 1, 0, curPath, minDist, path);
+/**
+ * Returns what every thread of the last backtracking search did.
+ *
+ * @brief Returns the per-thread statistics of BT().
+ * @return One entry per worker thread.
+ */
 
-    return minDist;
+const vector<SearchStats> &Services::getSearchStats() const {
+    return searchStats;
+}
+
+/**
+ * Returns the memory the Held-Karp table of a graph takes: a float cost and a one-byte parent for every subset of the
+ * vertices other than the start and every vertex of the subset.
+ *
+ * @brief Returns the memory of the Held-Karp table.
+ * @param n The number of vertices.
+ * @return The number of bytes.
+ */
+
+size_t Services::heldKarpBytes(int n) {
+    if (n < 2) {
+        return 0;
+    }
+    if (n - 1 >= 40) {
+        return numeric_limits<size_t>::max();
+    }
+    return ((size_t) 1 << (n - 1)) * (size_t) (n - 1) * (sizeof(float) + sizeof(uint8_t));
 }
 
 /**
- * Recursive function to find the shortest path using Backtracking algorithm.
+ * Calculates the shortest tour exactly with the Held-Karp dynamic program over subsets of the vertices.
+ *
+ * The vertices other than the start are numbered 0..m-1, and cost[S * m + j] is the length of the shortest path that
+ * leaves the start, visits exactly the vertices of the subset S and ends at j. The tour closes the cheapest full path.
  *
- * @brief Recursive function to find the shortest path.
+ * @brief Calculates the shortest tour with the Held-Karp algorithm.
  * @param graph The graph object representing the vertices and edges.
- * @param curIndex The current index in the path being constructed.
- * @param curDist The current distance of the path.
- * @param curPath The current path being constructed.
- * @param minDist Reference to the minimum distance found so far.
- * @param path An array to store the shortest path found.
- * @note The time complexity in the worst case is O(2^n).
+ * @param path An array to store the shortest tour found, as dense indices.
+ * @return The distance of the shortest tour, or -1 if there is none or the table would exceed HELD_KARP_MAX_BYTES.
+ * @note O(2^n n^2) time and O(2^n n) memory.
  */
 
-void Services::BTRec(Graph &graph, int curIndex, double curDist, int curPath[], double &minDist, int path[]) {
-    const unordered_map<int, Vertex*> nodes= graph.getVertexSet();
-    double **distMatrix = graph.getDistMatrix();
-    auto current_time = chrono::high_resolution_clock::now();
-    auto elapsed_time = chrono::duration_cast<chrono::seconds>(current_time - start).count();
-    if (elapsed_time > 30) {
-        minDist = -1;
-        return;
+double Services::HK(const Graph &graph, int path[]) {
+    setDistances(graph);
+    int n = size;
+    int root = graph.getStartIndex();
+    if (n == 1) {
+        path[0] = root;
+        return 0;
+    }
+    if (heldKarpBytes(n) > HELD_KARP_MAX_BYTES) {
+        return -1;
+    }
+
+    const float none = numeric_limits<float>::infinity();
+    int m = n - 1;
+    vector<int> others;
+    for (int i = 0; i < n; i++) {
+        if (i != root) {
+            others.push_back(i);
+        }
+    }
+    auto weight = [this, none](int i, int j) {
+        double d = distances(i, j);
+        return d > 0 ? (float) d : none;
+    };
+    vector<float> dist((size_t) m * m);
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < m; j++) {
+            dist[(size_t) i * m + j] = weight(others[i], others[j]);
+        }
+    }
+
+    size_t subsets = (size_t) 1 << m;
+    vector<float> cost(subsets * m, none);
+    vector<uint8_t> parents(subsets * m, UINT8_MAX);
+    for (int j = 0; j < m; j++) {
+        cost[((size_t) 1 << j) * m + j] = weight(root, others[j]);
     }
-    if (curIndex == nodes.size() && distMatrix[curPath[curIndex - 1]][curPath[0]] != 0) {
-            curDist += distMatrix[curPath[curIndex - 1]][0];
-            if (curDist < minDist) {
-                minDist = curDist;
-                for (unsigned int i = 0; i < nodes.size(); i++) {
-                    path[i] = curPath[i];
+    for (int k = 2; k <= m; k++) {
+        heldKarpLayer(m, k, dist, cost, parents);
+    }
+
+    size_t full = subsets - 1;
+    int last = -1;
+    float best = none;
+    for (int j = 0; j < m; j++) {
+        float tour = cost[full * m + j] + weight(others[j], root);
+        if (tour < best) {
+            best = tour;
+            last = j;
+        }
+    }
+    if (last == -1) {
+        return -1;
+    }
+
+    path[0] = root;
+    size_t subset = full;
+    for (int index = m; index > 0; index--) {
+        path[index] = others[last];
+        int previous = parents[subset * m + last];
+        subset ^= (size_t) 1 << last;
+        last = previous;
+    }
+    return pathCost(path);
+}
+
+/**
+ * Computes one layer of the Held-Karp table: the cheapest paths from the start through every subset of k vertices,
+ * from the paths through k - 1 vertices. Each subset only reads the previous layer, so the subsets are split between
+ * threads.
+ *
+ * The subsets of k vertices are enumerated in increasing order; every block of them starts from the subset of its
+ * rank, found through the binomial coefficients, and steps to the next one with Gosper's hack.
+ *
+ * @brief Fills one layer of the Held-Karp table.
+ * @param m The number of vertices other than the start.
+ * @param k The number of vertices in the subsets of the layer.
+ * @param dist The m x m distances between the vertices other than the start, infinity for missing edges.
+ * @param cost The cost of the cheapest path through each subset ending at each of its vertices, indexed by
+ * subset * m + vertex.
+ * @param parents The vertex before the last one on each of those paths.
+ * @note O(C(m, k) k^2).
+ */
+
+void Services::heldKarpLayer(int m, int k, const vector<float> &dist, vector<float> &cost, vector<uint8_t> &parents) {
+    vector<vector<size_t>> binomial(m + 1, vector<size_t>(k + 1, 0));
+    for (int i = 0; i <= m; i++) {
+        binomial[i][0] = 1;
+        for (int j = 1; j <= min(i, k); j++) {
+            binomial[i][j] = binomial[i - 1][j - 1] + (j <= i - 1 ? binomial[i - 1][j] : 0);
+        }
+    }
+
+    parallelFor(binomial[m][k], 4096, [&](size_t begin, size_t end) {
+        // The subset of rank begin among the subsets of k vertices, in increasing order
+        size_t subset = 0;
+        size_t rank = begin;
+        for (int bit = m - 1, left = k; left > 0; bit--) {
+            if (binomial[bit][left] <= rank) {
+                subset |= (size_t) 1 << bit;
+                rank -= binomial[bit][left];
+                left--;
+            }
+        }
+        for (size_t r = begin; r < end; r++) {
+            for (size_t rest = subset; rest != 0; rest &= rest - 1) {
+                int j = __builtin_ctzll(rest);
+                size_t without = subset ^ ((size_t) 1 << j);
+                const float *before = &cost[without * m];
+                float best = numeric_limits<float>::infinity();
+                int from = UINT8_MAX;
+                for (size_t options = without; options != 0; options &= options - 1) {
+                    int i = __builtin_ctzll(options);
+                    float through = before[i] + dist[(size_t) i * m + j];
+                    if (through < best) {
+                        best = through;
+                        from = i;
+                    }
                 }
+                cost[subset * m + j] = best;
+                parents[subset * m + j] = (uint8_t) from;
             }
-        return;
-    }
+            // Gosper's hack: the next larger subset with as many vertices
+            size_t lowest = subset & -subset;
+            size_t carry = subset + lowest;
+            subset = (((carry ^ subset) >> 2) / lowest) | carry;
+        }
+    });
+}
 
-    for (int i = 1; i < nodes.size(); i++) {
-        if (distMatrix[curPath[curIndex-1]][i] > 0 && curDist+distMatrix[curPath[curIndex-1]][i]<minDist && !nodes.at(i)->isVisited()){
-            nodes.at(i)->setVisited(true);
-            curPath[curIndex] = i;
-            BTRec(graph, curIndex + 1, curDist + distMatrix[curPath[curIndex-1]][i] , curPath, minDist, path);
-            nodes.at(i)->setVisited(false);
-       }
+/**
+ * Calculates the shortest tour exactly with a branch-and-bound search, starting from the nearest neighbour tour.
+ *
+ * @brief Calculates the shortest tour with branch and bound.
+ * @param graph The graph object representing the vertices and edges.
+ * @param path An array to store the shortest tour found, as dense indices.
+ * @return The distance of the shortest tour found, or -1 if there is none or the graph has more than
+ * BranchAndBound::MAX_VERTICES vertices.
+ * @note Exponential in the worst case; the bounds prune most of the O(n!) tours on 30 to 40 vertices.
+ */
+
+double Services::BB(const Graph &graph, int path[]) {
+    setDistances(graph);
+    optimal = true;
+    if (size > BranchAndBound::MAX_VERTICES) {
+        return -1;
     }
+    vector<int> initial(size, -1);
+    double initialDist = 0.0;
+    NN(graph, initial.data(), initialDist);
+
+    BranchAndBound search(distances, graph.getStartIndex());
+    double minDist = search.solve(path, initial.data(), BB_TIME_LIMIT);
+    optimal = search.isOptimal();
+    LOG(Logger::INFO, "Branch and bound bounded " << search.getNodes() << " nodes");
+    return minDist;
+}
+
+/**
+ * Checks if the last branch-and-bound search proved its tour optimal.
+ *
+ * @brief Checks if the last tour of BB() is optimal.
+ * @return False if the search stopped after BB_TIME_LIMIT seconds, true otherwise.
+ */
+
+bool Services::isOptimal() const {
+    return optimal;
 }
 
 /**
@@ -74,83 +250,378 @@ void Services::BTRec(Graph &graph, int curIndex, double curDist, int curPath[],
  *
  * @brief Calculates the minimum spanning tree using Prim's algorithm.
  * @param graph The graph object representing the vertices and edges.
- * @param path An array to store the traversal path of the minimum spanning tree.
+ * @param path An array to store the traversal path of the minimum spanning tree, as dense indices.
  * @return The total weight of the minimum spanning tree.
- * @note This function has a time complexity of O(|V|^2), where |V| is the number of vertices in the graph.
+ * @note This function has a time complexity of O(|V|^2), where |V| is the number of vertices in the graph, plus the
+ * 2-opt pass that shortens the preorder tour; the returned weight is still that of the tree walk.
  */
 
 
-double Services::TAH(Graph &graph, int path[]){
-    MutablePriorityQueue<Vertex> aux;
-    std::unordered_map<Vertex*, Edge*> mst;
+double Services::TAH(const Graph &graph, int path[]){
+    setDistances(graph);
+    SpanningTree tree;
+    tree.root = graph.getStartIndex();
+    if(distances.isComplete()){
+        primDense(tree);
+    }
+    else{
+        primSparse(graph, tree);
+    }
+    double minDist = 0.0;
+    preorderTraversal(graph, tree, path, minDist);
+    twoOpt(graph, path);
+    return minDist;
+}
+
+/**
+ * Builds the minimum spanning tree with Prim's algorithm over the edges of the graph.
+ *
+ * Children are linked in adjacency order.
+ *
+ * @brief Builds the minimum spanning tree of a sparse graph.
+ * @param graph The graph object representing the vertices and edges.
+ * @param tree The tree to fill; its root must be set.
+ * @param penalty Added to the weight of every edge at each of its ends, or empty for the plain weights. The weights
+ * kept in the tree are always the plain ones.
+ * @param excluded A vertex left out of the tree, or -1.
+ * @return False if the deadline of the running bound passed before the tree was complete.
+ * @note O(|E| log |V|).
+ */
 
-    Vertex* root = graph.findVertex(0);
-    root->setDist(0);
+bool Services::primSparse(const Graph &graph, SpanningTree &tree, const vector<double> &penalty, int excluded){
+    IndexPriorityQueue aux(work);
+    int n = graph.getNumVertex();
+    vector<size_t> &mst = work.path;    // edge of the graph that links each vertex to its parent
+    const CompactGraph &adj = graph.getAdjacency();
+
+    int root = tree.root;
+    work.dist[root] = 0;
     aux.insert(root);
 
 
-    for(auto v : graph.getVertexSet()){
-        if(v.first != 0 && v.second->getId() != 0){
-            v.second->setDist(numeric_limits<double>::max());
-            aux.insert(v.second);
+    for(int i = 0; i < n; i++){
+        work.visited[i] = i == excluded;
+        mst[i] = SIZE_MAX;
+        if(i != root && i != excluded){
+            work.dist[i] = numeric_limits<double>::max();
+            aux.insert(i);
+        }
+    }
+
+    for(int step = 0; !aux.empty(); step++){
+        if(expired(step)){
+            return false;
+        }
+        int cur = aux.extractMin();
+        work.visited[cur] = true;
+
+        NeighbourView edges = adj.neighbours(cur);
+        size_t first = adj.firstEdge(cur);
+        for(size_t k = 0; k < edges.size(); k++){
+            int dest = edges.target(k);
+            double weight = penalty.empty() ? edges.weight(k) : edges.weight(k) + penalty[cur] + penalty[dest];
+            if(!work.visited[dest] && weight < work.dist[dest]){
+                mst[dest] = first + k;
+                work.dist[dest] = weight;
+                aux.decreaseKey(dest);
+            }
         }
     }
 
-    unordered_set<Vertex*> visited;
+    tree.parent.assign(n, -1);
+    tree.weight.assign(n, 0.0);
+    vector<int> order;
+    for(int u = 0; u < n; u++){
+        NeighbourView edges = adj.neighbours(u);
+        size_t first = adj.firstEdge(u);
+        for(size_t k = 0; k < edges.size(); k++){
+            int dest = edges.target(k);
+            if(mst[dest] == first + k){
+                tree.parent[dest] = u;
+                tree.weight[dest] = edges.weight(k);
+                order.push_back(dest);
+            }
+        }
+    }
+    linkChildren(tree, order);
+    return true;
+}
 
-    while(!aux.empty()){
-        auto cur = aux.extractMin();
-        cur->setVisited(true);
+/**
+ * Builds the minimum spanning tree with Prim's algorithm over every pair of vertices, one row of distances at a time.
+ *
+ * Children are linked in index order.
+ *
+ * @brief Builds the minimum spanning tree of the complete graph.
+ * @param tree The tree to fill; its root must be set.
+ * @param penalty Added to the weight of every edge at each of its ends, or empty for the plain weights. The weights
+ * kept in the tree are always the plain ones.
+ * @param excluded A vertex left out of the tree, or -1.
+ * @return False if the deadline of the running bound passed before the tree was complete.
+ * @note O(|V|^2) time and O(|V|) memory.
+ */
 
-        for(auto edge : cur->getAdj()){
-            auto dest = edge->getDest();
-            if(!dest->isVisited() && edge->getWeight() < dest->getDist()){
-                mst[dest] = edge;
-                dest->setDist(edge->getWeight());
-                aux.decreaseKey(dest);
+bool Services::primDense(SpanningTree &tree, const vector<double> &penalty, int excluded){
+    int n = size;
+    vector<double> key(n, numeric_limits<double>::max());
+    vector<bool> inTree(n, false);
+    if(excluded != -1){
+        inTree[excluded] = true;
+    }
+    vector<double> row(n);
+    tree.parent.assign(n, -1);
+    tree.weight.assign(n, 0.0);
+    key[tree.root] = 0;
+
+    for(int step = 0; step < n; step++){
+        if(expired(step)){
+            return false;
+        }
+        int cur = -1;
+        double best = numeric_limits<double>::max();
+        for(int v = 0; v < n; v++){
+            if(!inTree[v] && key[v] < best){
+                best = key[v];
+                cur = v;
+            }
+        }
+        if(cur == -1){
+            break;
+        }
+        inTree[cur] = true;
+        distances.row(cur, row.data());
+        for(int v = 0; v < n; v++){
+            double weight = penalty.empty() ? row[v] : row[v] + penalty[cur] + penalty[v];
+            if(!inTree[v] && weight < key[v]){
+                key[v] = weight;
+                tree.parent[v] = cur;
+                tree.weight[v] = row[v];
             }
         }
     }
-    int index = 0;
-    double minDist = 0.0;
-    preorderTraversal(root, visited, mst, path, index, minDist);
-    return minDist;
+
+    vector<int> order;
+    for(int v = 0; v < n; v++){
+        if(tree.parent[v] != -1){
+            order.push_back(v);
+        }
+    }
+    linkChildren(tree, order);
+    return true;
+}
+
+/**
+ * Groups the children of every vertex of a tree whose parents are set.
+ *
+ * @brief Links the children of a tree.
+ * @param tree The tree whose children are filled.
+ * @param order The non-root vertices of the tree, in the order their parents should visit them.
+ */
+
+void Services::linkChildren(SpanningTree &tree, const vector<int> &order){
+    int n = (int) tree.parent.size();
+    tree.childStart.assign(n + 1, 0);
+    for(int v : order){
+        tree.childStart[tree.parent[v] + 1]++;
+    }
+    for(int v = 0; v < n; v++){
+        tree.childStart[v + 1] += tree.childStart[v];
+    }
+    tree.children.resize(order.size());
+    vector<int> cursor(tree.childStart.begin(), tree.childStart.end() - 1);
+    for(int v : order){
+        tree.children[cursor[tree.parent[v]]++] = v;
+    }
+}
+
+/**
+ * Builds the minimum 1-tree of the graph under vertex penalties: a minimum spanning tree of every vertex but one,
+ * plus the two cheapest edges of that vertex. Every tour is a 1-tree in which every vertex has degree 2.
+ *
+ * @brief Builds a minimum 1-tree.
+ * @param graph The graph object representing the vertices and edges.
+ * @param special The vertex left out of the spanning tree.
+ * @param penalty Added to the weight of every edge at each of its ends.
+ * @param degree Receives the degree of every vertex in the 1-tree.
+ * @return The weight of the 1-tree with the penalties, minus twice their sum, infinity if the graph has no 1-tree, or
+ * minus infinity if the deadline of the running bound passed first.
+ * @note O(|V|^2) on complete graphs, O(|E| log |V|) otherwise.
+ */
+
+double Services::oneTree(const Graph &graph, int special, const vector<double> &penalty, vector<int> &degree){
+    int n = size;
+    SpanningTree tree;
+    tree.root = special == 0 ? 1 : 0;
+    bool built = distances.isComplete() ? primDense(tree, penalty, special) : primSparse(graph, tree, penalty, special);
+    if(!built){
+        return -numeric_limits<double>::infinity();
+    }
+
+    degree.assign(n, 0);
+    double weight = 0.0;
+    for(int v = 0; v < n; v++){
+        if(v == special || v == tree.root){
+            continue;
+        }
+        if(tree.parent[v] == -1){
+            return numeric_limits<double>::infinity();
+        }
+        weight += tree.weight[v] + penalty[v] + penalty[tree.parent[v]];
+        degree[v]++;
+        degree[tree.parent[v]]++;
+    }
+
+    // Join the special vertex by its two cheapest edges
+    int first = -1, second = -1;
+    double firstWeight = numeric_limits<double>::max(), secondWeight = numeric_limits<double>::max();
+    for(int v = 0; v < n; v++){
+        double d = distances(special, v);
+        if(v == special || d <= 0){
+            continue;
+        }
+        d += penalty[special] + penalty[v];
+        if(d < firstWeight){
+            second = first;
+            secondWeight = firstWeight;
+            first = v;
+            firstWeight = d;
+        }
+        else if(d < secondWeight){
+            second = v;
+            secondWeight = d;
+        }
+    }
+    if(second == -1){
+        return numeric_limits<double>::infinity();
+    }
+    weight += firstWeight + secondWeight;
+    degree[special] = 2;
+    degree[first]++;
+    degree[second]++;
+
+    for(int v = 0; v < n; v++){
+        weight -= 2 * penalty[v];
+    }
+    return weight;
 }
 
 /**
  * Performs a preorder traversal of the minimum spanning tree to generate a traversal path.
  *
+ * Every tree edge is counted twice, once on the way down and once on the way back up. The traversal keeps its own
+ * stack, so trees with tens of thousands of levels do not overflow the call stack.
+ *
  * @brief Performs a preorder traversal of the minimum spanning tree.
- * @param vertex The current vertex being visited in the traversal.
- * @param visited A set of visited vertices.
- * @param mst A map representing the minimum spanning tree.
- * @param path An array to store the traversal path.
- * @param index The current index in the traversal path.
+ * @param graph The graph object representing the vertices and edges.
+ * @param tree The minimum spanning tree.
+ * @param path An array to store the traversal path, as dense indices.
  * @param minDist Reference to the total weight of the minimum spanning tree.
  */
 
-void Services::preorderTraversal(Vertex* vertex, std::unordered_set<Vertex*>& visited, std::unordered_map<Vertex*, Edge*>& mst, int path[], int& index, double& minDist) {
-    visited.insert(vertex);
-    path[index++] = vertex->getId();
-
-    for (const auto e : vertex->getAdj()) {
-        auto search = mst.find(e->getDest());
-        if (search != mst.end() && search->second == e) {
-            cout << "Edge: " << e->getOrig()->getId() << " - " << e->getDest()->getId() << endl;
-            minDist += e->getWeight();
-            preorderTraversal(e->getDest(), visited, mst, path, index, minDist);
+void Services::preorderTraversal(const Graph& graph, const SpanningTree& tree, int path[], double& minDist) {
+    int index = 0;
+    path[index++] = tree.root;
+    vector<pair<int, int>> stack = {{tree.root, tree.childStart[tree.root]}};
+
+    while (!stack.empty()) {
+        int vertex = stack.back().first;
+        int next = stack.back().second;
+        if (next < tree.childStart[vertex + 1]) {
+            int child = tree.children[next];
+            stack.back().second++;
+            LOG(Logger::DEBUG, "Edge: " << graph.idOf(vertex) << " - " << graph.idOf(child));
+            minDist += tree.weight[child];
+            path[index++] = child;
+            stack.emplace_back(child, tree.childStart[child]);
+        }
+        else {
+            stack.pop_back();
+            if (!stack.empty()) {
+                // Distance from the subtree back to its parent
+                LOG(Logger::DEBUG, "Edge: " << graph.idOf(stack.back().first) << " - " << graph.idOf(vertex));
+                minDist += tree.weight[vertex];
+            }
         }
     }
+}
 
-    // Calculate distance from the last vertex back to the root
-    if (vertex->getId() != 0) {
-        auto search = mst.find(vertex);
-        if (search != mst.end()) {
-            auto edge = search->second;
-            cout << "Edge: " << edge->getOrig()->getId() << " - " << edge->getDest()->getId() << endl;
-            minDist += edge->getWeight();
+/**
+ * Shortens a tour with 2-opt moves that join a vertex to one of its candidate neighbours, until no such move
+ * shortens it or TWO_OPT_TIME_LIMIT passes.
+ *
+ * A move replaces the edges (a, b) and (c, d), b following a and d following c, by (a, c) and (b, d), which reverses
+ * the path from b to c. It can only pay off if c is nearer to a than b is, and the candidates are sorted, so the scan
+ * of a stops at the first candidate that is not. The shorter side of the tour is the one reversed. Moves never
+ * remove or add a missing edge.
+ *
+ * @brief Improves a tour with candidate-list 2-opt.
+ * @param graph The graph object representing the vertices and edges.
+ * @param path The tour, as dense indices; it still starts at the same vertex afterwards.
+ * @note O(|V| k) per pass over the tour, where k is CandidateSet::DEFAULT_K, plus O(|V|) per move made.
+ */
+
+void Services::twoOpt(const Graph& graph, int path[]) {
+    int n = size;
+    if(n < 4){
+        return;
+    }
+    const CandidateSet &candidates = graph.getCandidates();
+    int first = path[0];
+    vector<int> tour(path, path + n);
+    vector<int> position(n);
+    for(int i = 0; i < n; i++){
+        position[tour[i]] = i;
+    }
+    auto stop = chrono::high_resolution_clock::now()
+        + chrono::duration_cast<chrono::high_resolution_clock::duration>(chrono::duration<double>(TWO_OPT_TIME_LIMIT));
+    bool improved = true;
+    bool expired = false;
+    while(improved && !expired){
+        improved = false;
+        for(int i = 0; i < n && !expired; i++){
+            expired = (i & 255) == 0 && chrono::high_resolution_clock::now() > stop;
+            int a = tour[i];
+            int b = tour[(i + 1) % n];
+            double ab = distances(a, b);
+            if(ab == 0){
+                continue;
+            }
+            NeighbourView near = candidates.of(a);
+            for(size_t k = 0; k < near.size() && near.weight(k) < ab; k++){
+                int c = near.target(k);
+                int j = position[c];
+                int d = tour[(j + 1) % n];
+                if(c == b || d == a){
+                    continue;
+                }
+                double bd = distances(b, d);
+                double cd = distances(c, d);
+                if(bd == 0 || cd == 0 || near.weight(k) + bd >= (ab + cd) * (1 - GAP_TOLERANCE)){
+                    continue;
+                }
+                // Reverse tour[i + 1 .. j], or the rest of the tour if it is shorter, which gives the same cycle
+                int start = (i + 1) % n;
+                int length = (j - start + n) % n + 1;
+                if(2 * length > n){
+                    start = (j + 1) % n;
+                    length = n - length;
+                }
+                for(int t = 0; t < length / 2; t++){
+                    int p = (start + t) % n;
+                    int q = (start + length - 1 - t) % n;
+                    swap(tour[p], tour[q]);
+                    position[tour[p]] = p;
+                    position[tour[q]] = q;
+                }
+                improved = true;
+                break;
+            }
         }
     }
+    int offset = position[first];
+    for(int i = 0; i < n; i++){
+        path[i] = tour[(offset + i) % n];
+    }
 }
 
 /**
@@ -158,45 +629,96 @@ void Services::preorderTraversal(Vertex* vertex, std::unordered_set<Vertex*>& vi
  *
  * @brief Generates a nearest neighbor solution to the Traveling Salesman Problem.
  * @param graph The graph object representing the vertices and edges.
- * @param path An array to store the generated path.
+ * @param path An array to store the generated path, as dense indices.
  * @param minDist Reference to the minimum distance found.
- * @note This function has a time complexity of O(|V|^2), where |V| is the number of vertices in the graph.
+ * @note O((|V| + |E|) log |V|) on average on geo graphs, where the nearest unvisited vertex is found in a
+ * SpatialIndex, O(|V|^2) on a metric closure and O(|V| + |E|) on other graphs, which only follow edges.
  */
 
 void Services::NN(const Graph& graph, int *path, double &minDist) {
     int index = 0;
-    unordered_map<int, Vertex*> vertexSet = graph.getVertexSet();
-    unordered_set<int> visited;
-    visited.insert(0);
-    path[0] = 0;
-    int cur = 0;
-    while(visited.size() < vertexSet.size()){
-        vertexSet.at(cur)->setDist(numeric_limits<double>::max());
+    int n = graph.getNumVertex();
+    const CompactGraph &adj = graph.getAdjacency();
+    vector<bool> visited(n, false);
+    int first = graph.getStartIndex();
+    int count = 1;
+    visited[first] = true;
+    path[0] = first;
+    int cur = first;
+    // On complete graphs every unvisited vertex is a candidate. On geo graphs the nearest is found in a k-d tree of
+    // the coordinates, apart from the neighbours of cur, whose distance is the edge weight and not the haversine
+    // distance; on a metric closure the row of cur is scanned
+    unique_ptr<SpatialIndex> spatial;
+    vector<int> hidden;
+    vector<double> row;
+    if(distances.isGeometric()){
+        spatial = make_unique<SpatialIndex>(graph);
+        spatial->remove(first);
+    }
+    else if(distances.isComplete()){
+        row.resize(n);
+    }
+    while(count < n){
+        double best = numeric_limits<double>::max();
         int next = -1;
 
-        for(const auto temp : vertexSet.at(cur)->getAdj()){
-            if(visited.find(temp->getDest()->getId()) == visited.end()){
-                double dist = temp->getWeight();
-                if(vertexSet.at(cur)->getDist() > dist){
-                    vertexSet.at(cur)->setDist(dist);
-                    next = temp->getDest()->getId();
+        if(spatial){
+            for(CompactEdge temp : adj.neighbours(cur)){
+                if(temp.dest == cur || visited[temp.dest]){
+                    continue;
+                }
+                double d = distances(cur, temp.dest);
+                if(d < best || (d == best && temp.dest < next)){
+                    best = d;
+                    next = temp.dest;
+                }
+                if(spatial->remove(temp.dest)){
+                    hidden.push_back(temp.dest);
+                }
+            }
+            int nearest = spatial->nearest(cur);
+            if(nearest != -1){
+                double d = distances(cur, nearest);
+                if(d < best || (d == best && nearest < next)){
+                    best = d;
+                    next = nearest;
+                }
+            }
+            for(int v : hidden){
+                spatial->restore(v);
+            }
+            hidden.clear();
+        }
+        else if(!row.empty()){
+            distances.row(cur, row.data());
+            for(int v = 0; v < n; v++){
+                if(!visited[v] && best > row[v]){
+                    best = row[v];
+                    next = v;
+                }
+            }
+        }
+        else{
+            for(CompactEdge temp : adj.neighbours(cur)){
+                if(!visited[temp.dest] && best > temp.weight){
+                    best = temp.weight;
+                    next = temp.dest;
                 }
             }
         }
         if(next == -1){
             break;}
-        minDist += vertexSet.at(cur)->getDist();
-        visited.insert(next);
+        minDist += best;
+        visited[next] = true;
+        if(spatial){
+            spatial->remove(next);
+        }
+        count++;
         index++;
         path[index] = next;
         cur = next;
     }
-    for(auto e : vertexSet.at(cur)->getAdj()){
-        if(e->getDest()->getId() == 0){
-            minDist += e->getWeight();
-            break;
-        }
-    }
+    minDist += distances(cur, first);
 }
 
 /**
@@ -242,15 +764,15 @@ bool Services::geneticMutation(unordered_map<double, int*> &candidates, int cons
  *
  * @brief Solves the Traveling Salesman Problem using a Genetic Algorithm.
  * @param graph The graph object representing the vertices and edges.
- * @param path An array to store the generated path.
+ * @param path An array to store the generated path, as dense indices.
  * @return The minimum distance of the TSP solution.
  * @note This function has a time complexity of O(|V|^2), where |V| is the number of vertices in the graph.
  */
 
 
-double Services::GA(Graph &graph, int *path) {
+double Services::GA(const Graph &graph, int *path) {
     unordered_map<double, int*> candidates;
-    setDistMatrix(graph.getDistMatrix(), graph.getNumVertex());
+    setDistances(graph);
     double minDist = 0.0;
     double startDist = minDist;
     double upperBound = 0.0;
@@ -266,11 +788,96 @@ double Services::GA(Graph &graph, int *path) {
     return minDist;
 }
 
+/**
+ * Calculates the Held-Karp lower bound of the shortest tour: the weight of the minimum 1-tree, raised by vertex
+ * penalties found with subgradient optimisation. Any penalties give a valid bound, so the search can stop at any
+ * step and the best bound seen is kept.
+ *
+ * Each step moves the penalties towards vertices of degree 2 in the 1-tree, by the Polyak step
+ * scale * (upperBound - bound) / |degree - 2|^2. The scale starts at 2 and halves whenever 20 steps go by without a
+ * better bound. The deadline is checked inside Prim's algorithm, since one 1-tree of a large geographic graph can
+ * take seconds.
+ *
+ * @brief Calculates a lower bound of the shortest tour.
+ * @param graph The graph object representing the vertices and edges.
+ * @param upperBound The length of a known tour, which sizes the steps and stops the search once reached.
+ * @return A length no tour is shorter than, at least the weight of the plain 1-tree; infinity if the graph has no
+ * tour, or 0 if not even the plain 1-tree was complete in time.
+ * @note O(k |V|^2) for k steps, at most LOWER_BOUND_ITERATIONS.
+ */
+
+double Services::lowerBound(const Graph &graph, double upperBound){
+    setDistances(graph);
+    int n = size;
+    if(n < 3){
+        return 0.0;
+    }
+    limited = true;
+    deadline = chrono::high_resolution_clock::now()
+               + chrono::duration_cast<chrono::high_resolution_clock::duration>(chrono::duration<double>(LOWER_BOUND_TIME_LIMIT));
+    int special = graph.getStartIndex();
+    vector<double> penalty(n, 0.0);
+    vector<int> degree;
+    double best = -numeric_limits<double>::infinity();
+    double scale = 2.0;
+    int stale = 0;
+    int step = 0;
+    for(; step < LOWER_BOUND_ITERATIONS; step++){
+        double bound = oneTree(graph, special, penalty, degree);
+        if(bound == numeric_limits<double>::infinity()){
+            limited = false;
+            return bound;
+        }
+        if(bound == -numeric_limits<double>::infinity()){
+            break;
+        }
+        if(bound > best){
+            best = bound;
+            stale = 0;
+        }
+        else if(++stale == 20){
+            scale /= 2;
+            stale = 0;
+        }
+        double norm = 0.0;
+        for(int v = 0; v < n; v++){
+            norm += (double) (degree[v] - 2) * (degree[v] - 2);
+        }
+        // A 1-tree whose vertices all have degree 2 is a tour, and so the shortest one
+        if(norm == 0 || upperBound - best <= GAP_TOLERANCE * upperBound){
+            break;
+        }
+        double length = scale * (upperBound - bound) / norm;
+        for(int v = 0; v < n; v++){
+            penalty[v] += length * (degree[v] - 2);
+        }
+    }
+    limited = false;
+    LOG(Logger::INFO, "Lower bound " << best << " after " << step << " subgradient steps");
+    // Even the plain 1-tree bounds every tour; only without a single complete 1-tree is there no bound at all
+    if(best == -numeric_limits<double>::infinity()){
+        return 0.0;
+    }
+    return best;
+}
+
+/**
+ * Checks the deadline of the running lower bound every 64 steps of Prim's algorithm.
+ *
+ * @brief Checks the deadline of lowerBound().
+ * @param step The number of steps Prim's algorithm has taken.
+ * @return True if a deadline is set and has passed.
+ */
+
+bool Services::expired(int step) const {
+    return limited && (step & 63) == 0 && chrono::high_resolution_clock::now() > deadline;
+}
+
 /**
  * Calculates the cost of a given path in the graph.
  *
  * @brief Calculates the cost of a given path.
- * @param path The path to calculate the cost for.
+ * @param path The path to calculate the cost for, as dense indices.
  * @return The cost of the path.
  * @note This function has a time complexity of O(|V|), where |V| is the number of vertices in the path.
  */
@@ -278,40 +885,31 @@ double Services::GA(Graph &graph, int *path) {
 double Services::pathCost(const int *path) {
     double dist = 0.0;
     for(int i = size-1; i > 0; i--){
-        dist += distMatrix[path[i]][path[i-1]];
+        dist += distances(path[i], path[i-1]);
     }
-    return dist+distMatrix[path[size-1]][0];
+    return dist+distances(path[size-1], path[0]);
 }
 
 /**
- * Sets the distance matrix in the Services class.
+ * Sets the distances used by the algorithms, without copying the graph's distance matrix, and clears the workspace.
  *
- * @brief Sets the distance matrix.
- * @param res The distance matrix.
- * @param n The size of the distance matrix.
+ * @brief Sets the distances.
+ * @param graph The graph object representing the vertices and edges.
  */
 
-void Services::setDistMatrix(double **res, int n){
-    this->size = n;
-    distMatrix = new double * [n];
-    for(int i=0; i<n; i++){
-        distMatrix[i] = new double[n];
-        for(int j = 0; j < n; j++){
-            distMatrix[i][j] = res[i][j];
-        }
-    }
+void Services::setDistances(const Graph& graph){
+    this->size = graph.getNumVertex();
+    distances = DistanceOracle(graph);
+    work.reset(size);
 }
 
 /**
  * Destructor for the Services class.
  *
  * @brief Destructor for the Services class.
- * @note This function deallocates the memory occupied by the distance matrix.
  */
 
-Services::~Services() {
-    deleteMatrix(distMatrix, size);
-}
+Services::~Services() = default;
 
 /**
  * Default constructor for the Services class.
@@ -14,69 +14,172 @@
 #include <algorithm>
 #include <unordered_set>
 #include <limits>
+#include <cmath>
 #include <chrono>
 #include <random>
 #include "Graph.h"
+#include "DistanceOracle.h"
+#include "Logger.h"
+#include "Workspace.h"
+#include "SpatialIndex.h"
+#include "BranchAndBound.h"
+#include "ParallelBacktracking.h"
 
 using namespace std;
 
+/**
+ * @brief The SpanningTree struct holds a rooted spanning tree by dense index.
+ */
+
+struct SpanningTree {
+    int root = 0; /**< The dense index of the root */
+    vector<int> parent; /**< The parent of each vertex, -1 for the root and for unreached vertices */
+    vector<double> weight; /**< The weight of the edge from each vertex to its parent */
+    vector<int> childStart; /**< The children of v are children[childStart[v], childStart[v + 1]) */
+    vector<int> children; /**< The children of every vertex, grouped by parent */
+};
+
 /**
  * @brief The Services class provides various algorithms for solving optimization problems on graphs.
+ *
+ * The algorithms only read the graph; their per-vertex state lives in the workspace of the Services object, so
+ * several Services objects can solve on the same loaded graph at the same time.
  */
 
 class Services {
 private:
     int size; /**< The size of the graph */
-    double **distMatrix = nullptr; /**< The distance matrix of the graph */
-    chrono::high_resolution_clock::time_point start;  /**< The start time for algorithm execution */
+    DistanceOracle distances; /**< The distances between the vertices of the graph */
+    Workspace work; /**< The per-vertex state of the running algorithm */
+    vector<SearchStats> searchStats; /**< What every thread of the last backtracking search did */
+    bool optimal = true; /**< Whether the last branch-and-bound search finished */
+    bool limited = false; /**< Whether Prim's algorithm must stop at the deadline */
+    chrono::high_resolution_clock::time_point deadline; /**< When the running lower bound stops */
+
+/**
+ * Computes one layer of the Held-Karp table: the cheapest paths from the start through every subset of k vertices,
+ * from the paths through k - 1 vertices. Each subset only reads the previous layer, so the subsets are split between
+ * threads.
+ *
+ * @brief Fills one layer of the Held-Karp table.
+ * @param m The number of vertices other than the start.
+ * @param k The number of vertices in the subsets of the layer.
+ * @param dist The m x m distances between the vertices other than the start, infinity for missing edges.
+ * @param cost The cost of the cheapest path through each subset ending at each of its vertices, indexed by
+ * subset * m + vertex.
+ * @param parents The vertex before the last one on each of those paths.
+ * @complexity O(C(m, k) k^2).
+ */
+
+    static void heldKarpLayer(int m, int k, const vector<float>& dist, vector<float>& cost, vector<uint8_t>& parents);
 
 /**
- * Recursive function to find the shortest path using Backtracking algorithm.
+ * Sets the distances used by the algorithms, without copying the graph's distance matrix, and clears the workspace.
  *
- * @brief Recursive function to find the shortest path.
+ * @brief Sets the distances.
  * @param graph The graph object representing the vertices and edges.
- * @param curIndex The current index in the path being constructed.
- * @param curDist The current distance of the path.
- * @param curPath The current path being constructed.
- * @param minDist Reference to the minimum distance found so far.
- * @param path An array to store the shortest path found.
- * @complexity The time complexity in the worst case is O(2^n).
  */
 
-    void BTRec(Graph& graph, int curIndex, double curDist, int curPath[], double& minDist,int path[]);
+    void setDistances(const Graph& graph);
 
 /**
- * Sets the distance matrix in the Services class.
+ * Builds the minimum spanning tree with Prim's algorithm over the edges of the graph.
  *
- * @brief Sets the distance matrix.
- * @param res The distance matrix.
- * @param n The size of the distance matrix.
+ * @brief Builds the minimum spanning tree of a sparse graph.
+ * @param graph The graph object representing the vertices and edges.
+ * @param tree The tree to fill; its root must be set.
+ * @param penalty Added to the weight of every edge at each of its ends, or empty for the plain weights. The weights
+ * kept in the tree are always the plain ones.
+ * @param excluded A vertex left out of the tree, or -1.
+ * @return False if the deadline of the running bound passed before the tree was complete.
+ * @complexity O(|E| log |V|).
  */
 
-    void setDistMatrix(double **res, int n);
+    bool primSparse(const Graph& graph, SpanningTree& tree, const vector<double>& penalty = {}, int excluded = -1);
+
+/**
+ * Builds the minimum spanning tree with Prim's algorithm over every pair of vertices, one row of distances at a time.
+ *
+ * @brief Builds the minimum spanning tree of the complete graph.
+ * @param tree The tree to fill; its root must be set.
+ * @param penalty Added to the weight of every edge at each of its ends, or empty for the plain weights. The weights
+ * kept in the tree are always the plain ones.
+ * @param excluded A vertex left out of the tree, or -1.
+ * @return False if the deadline of the running bound passed before the tree was complete.
+ * @complexity O(|V|^2) time and O(|V|) memory.
+ */
+
+    bool primDense(SpanningTree& tree, const vector<double>& penalty = {}, int excluded = -1);
+
+/**
+ * Builds the minimum 1-tree of the graph under vertex penalties: a minimum spanning tree of every vertex but one,
+ * plus the two cheapest edges of that vertex. Every tour is a 1-tree in which every vertex has degree 2.
+ *
+ * @brief Builds a minimum 1-tree.
+ * @param graph The graph object representing the vertices and edges.
+ * @param special The vertex left out of the spanning tree.
+ * @param penalty Added to the weight of every edge at each of its ends.
+ * @param degree Receives the degree of every vertex in the 1-tree.
+ * @return The weight of the 1-tree with the penalties, minus twice their sum, infinity if the graph has no 1-tree, or
+ * minus infinity if the deadline of the running bound passed first.
+ * @complexity O(|V|^2) on complete graphs, O(|E| log |V|) otherwise.
+ */
+
+    double oneTree(const Graph& graph, int special, const vector<double>& penalty, vector<int>& degree);
+
+/**
+ * Checks the deadline of the running lower bound every 64 steps of Prim's algorithm.
+ *
+ * @brief Checks the deadline of lowerBound().
+ * @param step The number of steps Prim's algorithm has taken.
+ * @return True if a deadline is set and has passed.
+ */
+
+    bool expired(int step) const;
+
+/**
+ * Groups the children of every vertex of a tree whose parents are set.
+ *
+ * @brief Links the children of a tree.
+ * @param tree The tree whose children are filled.
+ * @param order The non-root vertices of the tree, in the order their parents should visit them.
+ */
+
+    void linkChildren(SpanningTree& tree, const vector<int>& order);
 
 /**
  * Performs a preorder traversal of the minimum spanning tree to generate a traversal path.
  *
  * @brief Performs a preorder traversal of the minimum spanning tree.
- * @param vertex The current vertex being visited in the traversal.
- * @param visited A set of visited vertices.
- * @param mst A map representing the minimum spanning tree.
- * @param path An array to store the traversal path.
- * @param index The current index in the traversal path.
+ * @param graph The graph object representing the vertices and edges.
+ * @param tree The minimum spanning tree.
+ * @param path An array to store the traversal path, as dense indices.
  * @param minDist Reference to the total weight of the minimum spanning tree.
  */
 
-    void preorderTraversal(Vertex* vertex, std::unordered_set<Vertex*>& visited, std::unordered_map<Vertex*, Edge*>& mst, int path[], int& index, double& minDist);
+    void preorderTraversal(const Graph& graph, const SpanningTree& tree, int path[], double& minDist);
+
+/**
+ * Shortens a tour with 2-opt moves that join a vertex to one of its candidate neighbours, until no such move
+ * shortens it or TWO_OPT_TIME_LIMIT passes.
+ *
+ * @brief Improves a tour with candidate-list 2-opt.
+ * @param graph The graph object representing the vertices and edges.
+ * @param path The tour, as dense indices; it still starts at the same vertex afterwards.
+ * @complexity O(|V| k) per pass over the tour, where k is CandidateSet::DEFAULT_K, plus O(|V|) per move made.
+ */
+
+    void twoOpt(const Graph& graph, int path[]);
 
 /**
  * Generates a nearest neighbor solution to the Traveling Salesman Problem in a given graph.
  *
  * @brief Generates a nearest neighbor solution to the Traveling Salesman Problem.
  * @param graph The graph object representing the vertices and edges.
- * @param path An array to store the generated path.
+ * @param path An array to store the generated path, as dense indices.
  * @param minDist Reference to the minimum distance found.
- * @complexity This function has a time complexity of O(|V|^2), where |V| is the number of vertices in the graph.
+ * @complexity O((|V| + |E|) log |V|) on average on geo graphs, where the nearest unvisited vertex is found in a
+ * SpatialIndex, O(|V|^2) on a metric closure and O(|V| + |E|) on other graphs, which only follow edges.
  */
 
     void NN(const Graph& graph, int path[], double& minDist);
@@ -94,24 +197,12 @@ private:
 
     bool geneticMutation(unordered_map<double, int*> &candidates, int const candidate[], double upperBound, double &minDist);
 
-/**
- * Calculates the cost of a given path in the graph.
- *
- * @brief Calculates the cost of a given path.
- * @param path The path to calculate the cost for.
- * @return The cost of the path.
- * @complexity This function has a time complexity of O(|V|), where |V| is the number of vertices in the path.
- */
-
-    double pathCost(const int path []);
-
 public:
 
 /**
  * Destructor for the Services class.
  *
  * @brief Destructor for the Services class.
- * @note This function deallocates the memory occupied by the distance matrix.
  */
 
     ~Services();
@@ -124,40 +215,177 @@ public:
 
     Services();
 
+ /**
+ * The most seconds a backtracking search may run before it is given up.
+ */
+
+    static constexpr double BT_TIME_LIMIT = 30;
+
  /**
  * Calculates the shortest path using the Backtracking algorithm in a given graph.
  *
+ * The search tree is split between every hardware thread with work stealing, and they all prune against the best
+ * tour found by any of them.
+ *
  * @brief Calculates the shortest path using the Backtracking algorithm.
  * @param graph The graph object representing the vertices and edges.
- * @param path An array to store the shortest path found.
- * @return The minimum distance of the shortest path.
+ * @param path An array to store the shortest path found, as dense indices.
+ * @return The minimum distance of the shortest path, or -1 if there is none or the search takes longer than
+ * BT_TIME_LIMIT seconds.
  * @complexity This function has an exponential time complexity of O(2^n).
+ * @see ParallelBacktracking
  */
 
-    double BT(Graph& graph, int path[]);
+    double BT(const Graph& graph, int path[]);
+
+/**
+ * Returns what every thread of the last backtracking search did.
+ *
+ * @brief Returns the per-thread statistics of BT().
+ * @return One entry per worker thread.
+ */
+
+    const vector<SearchStats> &getSearchStats() const;
+
+/**
+ * The most memory the Held-Karp table may take.
+ */
+
+    static constexpr size_t HELD_KARP_MAX_BYTES = (size_t) 1 << 30;
+
+/**
+ * Returns the memory the Held-Karp table of a graph takes: a float cost and a one-byte parent for every subset of the
+ * vertices other than the start and every vertex of the subset.
+ *
+ * @brief Returns the memory of the Held-Karp table.
+ * @param n The number of vertices.
+ * @return The number of bytes.
+ */
+
+    static size_t heldKarpBytes(int n);
+
+/**
+ * Calculates the shortest tour exactly with the Held-Karp dynamic program over subsets of the vertices.
+ *
+ * Subsets are processed layer by layer by their number of vertices, each layer in parallel. Costs are kept as floats
+ * and parents as one byte to halve the table; the returned distance is recomputed in double along the tour.
+ *
+ * @brief Calculates the shortest tour with the Held-Karp algorithm.
+ * @param graph The graph object representing the vertices and edges.
+ * @param path An array to store the shortest tour found, as dense indices.
+ * @return The distance of the shortest tour, or -1 if there is none or the table would exceed HELD_KARP_MAX_BYTES
+ * (about 24 vertices).
+ * @complexity O(2^n n^2) time and O(2^n n) memory.
+ */
+
+    double HK(const Graph& graph, int path[]);
+
+/**
+ * The most seconds a branch-and-bound search may run before it settles for the best tour found.
+ */
+
+    static constexpr double BB_TIME_LIMIT = 300;
+
+/**
+ * Calculates the shortest tour exactly with a branch-and-bound search, starting from the nearest neighbour tour.
+ *
+ * @brief Calculates the shortest tour with branch and bound.
+ * @param graph The graph object representing the vertices and edges.
+ * @param path An array to store the shortest tour found, as dense indices.
+ * @return The distance of the shortest tour found, or -1 if there is none or the graph has more than
+ * BranchAndBound::MAX_VERTICES vertices.
+ * @complexity Exponential in the worst case; the bounds prune most of the O(n!) tours on 30 to 40 vertices.
+ * @see BranchAndBound
+ */
+
+    double BB(const Graph& graph, int path[]);
+
+/**
+ * Checks if the last branch-and-bound search proved its tour optimal.
+ *
+ * @brief Checks if the last tour of BB() is optimal.
+ * @return False if the search stopped after BB_TIME_LIMIT seconds, true otherwise.
+ */
+
+    bool isOptimal() const;
 
 /**
  * Calculates the minimum spanning tree using the Prim's algorithm in a given graph.
  *
  * @brief Calculates the minimum spanning tree using Prim's algorithm.
  * @param graph The graph object representing the vertices and edges.
- * @param path An array to store the traversal path of the minimum spanning tree.
+ * @param path An array to store the traversal path of the minimum spanning tree, as dense indices.
  * @return The total weight of the minimum spanning tree.
- * @complexity This function has a time complexity of O(|V|^2), where |V| is the number of vertices in the graph.
+ * @complexity This function has a time complexity of O(|V|^2), where |V| is the number of vertices in the graph,
+ * plus the 2-opt pass over the tour.
+ * @note The preorder tour is shortened by twoOpt() before it is returned; the returned weight is still that of the
+ * tree walk, at most twice the shortest tour. Graphs without a distance matrix but with coordinates are treated as complete, with missing edges measured
+ * by the haversine distance, and so are graphs whose matrix is a metric closure.
  */
 
-    double TAH(Graph &graph, int path[]);
+    double TAH(const Graph &graph, int path[]);
 
 /**
  * Solves the Traveling Salesman Problem using a Genetic Algorithm in a given graph.
  *
  * @brief Solves the Traveling Salesman Problem using a Genetic Algorithm.
  * @param graph The graph object representing the vertices and edges.
- * @param path An array to store the generated path.
+ * @param path An array to store the generated path, as dense indices.
  * @return The minimum distance of the TSP solution.
  */
 
-    double GA(Graph &graph, int path[]);
+    double GA(const Graph &graph, int path[]);
+
+/**
+ * Calculates the cost of a given path in the graph the last algorithm ran on, closing edge included.
+ *
+ * @brief Calculates the cost of a given path.
+ * @param path The path to calculate the cost for, as dense indices.
+ * @return The cost of the path.
+ * @complexity This function has a time complexity of O(|V|), where |V| is the number of vertices in the path.
+ */
+
+    double pathCost(const int path []);
+
+/**
+ * The most subgradient steps lowerBound() takes.
+ */
+
+    static constexpr int LOWER_BOUND_ITERATIONS = 1000;
+
+/**
+ * The most seconds the 2-opt pass over a TAH tour runs; the tour found so far is kept when it stops.
+ */
+
+    static constexpr double TWO_OPT_TIME_LIMIT = 10;
+
+/**
+ * The most seconds lowerBound() runs, checked inside Prim's algorithm; the bound found so far is still valid when it
+ * stops.
+ */
+
+    static constexpr double LOWER_BOUND_TIME_LIMIT = 10;
+
+/**
+ * The relative difference under which a tour and a lower bound are taken as equal; it absorbs rounding errors.
+ */
+
+    static constexpr double GAP_TOLERANCE = 1e-9;
+
+/**
+ * Calculates the Held-Karp lower bound of the shortest tour: the weight of the minimum 1-tree, raised by vertex
+ * penalties found with subgradient optimisation. Any penalties give a valid bound, so the search can stop at any
+ * step and the best bound seen is kept.
+ *
+ * @brief Calculates a lower bound of the shortest tour.
+ * @param graph The graph object representing the vertices and edges.
+ * @param upperBound The length of a known tour, which sizes the steps and stops the search once reached.
+ * @return A length no tour is shorter than, at least the weight of the plain 1-tree; infinity if the graph has no
+ * tour, or 0 if not even the plain 1-tree was complete in time.
+ * @complexity O(k |V|^2) for k steps, at most LOWER_BOUND_ITERATIONS.
+ */
+
+    double lowerBound(const Graph &graph, double upperBound);
 
 };
 
@@ -0,0 +1,302 @@
+//
+// Created by oem on 02/06/23.
+//
+
+#include "Snapshot.h"
+#include "MappedFile.h"
+#include <cstring>
+#include <fstream>
+#include <unordered_set>
+#include <unistd.h>
+
+static const char MAGIC[8] = {'D', 'A', 'G', 'R', 'A', 'P', 'H', '\0'};
+static const uint32_t HAS_COORDINATES = 2;
+static const uint64_t MAX_ENTRIES = 0xFFFFFFFF;
+
+/**
+ * @brief The fixed-size header at the start of every snapshot.
+ */
+
+struct SnapshotHeader {
+    char magic[8]; /**< Always MAGIC */
+    uint32_t version; /**< Snapshot::VERSION of the writer */
+    uint32_t flags; /**< HAS_COORDINATES if the graph had a nodes file */
+    uint64_t fingerprint; /**< Fingerprint of the source CSV files */
+    uint64_t checksum; /**< Hash of everything after the header */
+    uint64_t vertices; /**< Number of entries in the vertex table */
+    uint64_t edges; /**< Number of directed edges in the adjacency table, twice the number of undirected ones */
+    uint64_t namesBytes; /**< Size of the names block, padded to 8 bytes */
+};
+
+/**
+ * @brief One entry of the vertex table, in adjacency index order. Its edges are adjacency[firstEdge, next
+ * vertex's firstEdge).
+ */
+
+struct SnapshotVertex {
+    int32_t id;
+    uint32_t nameLength;
+    uint64_t nameOffset;
+    double longitude;
+    double latitude;
+    uint64_t firstEdge;
+};
+
+/**
+ * @brief One entry of the adjacency table, referring to its destination by its position in the vertex table.
+ */
+
+struct SnapshotEdge {
+    uint32_t dest;
+    uint32_t reserved; /**< Always 0, keeps the padding deterministic for the checksum */
+    double weight;
+};
+
+static_assert(sizeof(SnapshotHeader) % 8 == 0 && sizeof(SnapshotVertex) % 8 == 0 && sizeof(SnapshotEdge) % 8 == 0,
+              "snapshot records must keep the following tables 8-byte aligned");
+
+/**
+ * Checks that the tables described by a header fill exactly the bytes that follow it.
+ *
+ * Every count is bounded by the bytes still unaccounted for before it is multiplied, so a corrupt or crafted header
+ * cannot overflow its way past the check.
+ *
+ * @param header The snapshot header.
+ * @param available The number of bytes that follow the header.
+ * @return True if the payload has exactly the size the header describes.
+ */
+
+static bool payloadFits(const SnapshotHeader &header, uint64_t available) {
+    if (header.vertices > available / sizeof(SnapshotVertex)) {
+        return false;
+    }
+    available -= header.vertices * sizeof(SnapshotVertex);
+    if (header.edges > available / sizeof(SnapshotEdge)) {
+        return false;
+    }
+    available -= header.edges * sizeof(SnapshotEdge);
+    if (header.namesBytes > available) {
+        return false;
+    }
+    return header.namesBytes == available;
+}
+
+/**
+ * Gets the snapshot file used for a dataset.
+ *
+ * @param edges_file The path to the edges CSV file of the dataset.
+ * @return The path to the snapshot, next to the edges file.
+ */
+
+fs::path Snapshot::pathFor(const fs::path& edges_file) {
+    fs::path snapshot = edges_file;
+    return snapshot.replace_extension(".snapshot");
+}
+
+/**
+ * Hashes a block of memory eight bytes at a time.
+ *
+ * @param data The first byte of the block.
+ * @param size The size of the block in bytes.
+ * @param seed The starting value, so several blocks can be chained.
+ * @return The 64-bit hash of the block.
+ */
+
+uint64_t Snapshot::hash(const void *data, size_t size, uint64_t seed) {
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    uint64_t h = seed ^ 0x9E3779B97F4A7C15ULL ^ size;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, 8);
+        h = (h ^ word) * 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 32;
+    }
+    for (; i < size; i++) {
+        h = (h ^ bytes[i]) * 0x100000001B3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * Fingerprints the CSV files of a dataset by their names, sizes and modification times.
+ *
+ * @param sources The paths to the CSV files; empty paths are ignored.
+ * @return The fingerprint, which changes whenever any of the files changes.
+ */
+
+uint64_t Snapshot::fingerprint(const vector<fs::path>& sources) {
+    uint64_t h = VERSION;
+    for (const auto &source : sources) {
+        if (source.empty()) {
+            continue;
+        }
+        error_code ec;
+        string name = source.filename().string();
+        int64_t meta[2] = {(int64_t) fs::file_size(source, ec), 0};
+        auto time = fs::last_write_time(source, ec);
+        if (!ec) {
+            meta[1] = time.time_since_epoch().count();
+        }
+        h = hash(name.data(), name.size(), h);
+        h = hash(meta, sizeof(meta), h);
+    }
+    return h;
+}
+
+/**
+ * Writes a snapshot of a graph. The file is written under a temporary name and renamed into place, so a reader
+ * never maps a partially written snapshot.
+ *
+ * @param graph The loaded graph.
+ * @param file_name The path to the snapshot file.
+ * @param fingerprint The fingerprint of the CSV files the graph was loaded from.
+ * @return True if the snapshot was written, false otherwise.
+ */
+
+bool Snapshot::write(const Graph& graph, const fs::path& file_name, uint64_t fingerprint) {
+    const CompactGraph &adj = graph.getAdjacency();
+    size_t n = adj.getNumVertex();
+
+    vector<SnapshotVertex> vertices;
+    vector<SnapshotEdge> edges;
+    vertices.reserve(n);
+    edges.reserve(adj.getNumEdges());
+    string names;
+    for (size_t i = 0; i < n; i++) {
+        Vertex *v = graph.vertexAt((int) i);
+        vertices.push_back({v->getId(), (uint32_t) v->getName().size(), names.size(),
+                            v->getLongitude(), v->getLatitude(), edges.size()});
+        names += v->getName();
+        for (CompactEdge e : adj.neighbours((int) i)) {
+            edges.push_back({(uint32_t) e.dest, 0, e.weight});
+        }
+    }
+    names.resize((names.size() + 7) / 8 * 8, '\0');
+
+    SnapshotHeader header{};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.flags = graph.hasCoordinates() ? HAS_COORDINATES : 0;
+    header.fingerprint = fingerprint;
+    header.vertices = vertices.size();
+    header.edges = edges.size();
+    header.namesBytes = names.size();
+
+    uint64_t checksum = hash(vertices.data(), vertices.size() * sizeof(SnapshotVertex));
+    checksum = hash(edges.data(), edges.size() * sizeof(SnapshotEdge), checksum);
+    header.checksum = hash(names.data(), names.size(), checksum);
+
+    fs::path temporary = file_name;
+    temporary += ".tmp" + to_string(getpid());
+    ofstream out(temporary, ios::binary | ios::trunc);
+    if (!out) {
+        return false;
+    }
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(vertices.data()), vertices.size() * sizeof(SnapshotVertex));
+    out.write(reinterpret_cast<const char *>(edges.data()), edges.size() * sizeof(SnapshotEdge));
+    out.write(names.data(), names.size());
+    out.close();
+
+    error_code ec;
+    if (!out) {
+        fs::remove(temporary, ec);
+        return false;
+    }
+    fs::rename(temporary, file_name, ec);
+    return !ec;
+}
+
+/**
+ * Loads a graph from a snapshot through a read-only memory mapping.
+ *
+ * The snapshot is rejected before anything is added to the graph if its version, fingerprint, size or checksum
+ * does not match, or if its tables are inconsistent: edges out of range or two vertices with the same ID. The graph
+ * must be empty, so its vertex indices match the vertex table.
+ *
+ * @param graph An empty graph to fill; it is left untouched if the snapshot is rejected.
+ * @param file_name The path to the snapshot file.
+ * @param fingerprint The fingerprint of the current CSV files.
+ * @return True if the snapshot exists, is intact and matches the fingerprint, false otherwise.
+ */
+
+bool Snapshot::read(Graph& graph, const fs::path& file_name, uint64_t fingerprint) {
+    MappedFile file(file_name);
+    if (!file.isOpen() || file.size() < sizeof(SnapshotHeader) || graph.getNumVertex() != 0) {
+        return false;
+    }
+
+    SnapshotHeader header{};
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION
+        || header.fingerprint != fingerprint || header.vertices > MAX_ENTRIES || header.edges > MAX_ENTRIES
+        || !payloadFits(header, file.size() - sizeof(header))) {
+        return false;
+    }
+
+    size_t n = header.vertices;
+    const char *payload = file.data() + sizeof(header);
+    auto vertices = reinterpret_cast<const SnapshotVertex *>(payload);
+    auto edges = reinterpret_cast<const SnapshotEdge *>(payload + n * sizeof(SnapshotVertex));
+    const char *names = payload + n * sizeof(SnapshotVertex) + header.edges * sizeof(SnapshotEdge);
+
+    uint64_t checksum = hash(vertices, n * sizeof(SnapshotVertex));
+    checksum = hash(edges, header.edges * sizeof(SnapshotEdge), checksum);
+    checksum = hash(names, header.namesBytes, checksum);
+    if (checksum != header.checksum) {
+        return false;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        uint64_t last = i + 1 < n ? vertices[i + 1].firstEdge : header.edges;
+        if (vertices[i].firstEdge > last || last > header.edges
+            || vertices[i].nameOffset + vertices[i].nameLength > header.namesBytes) {
+            return false;
+        }
+    }
+    for (size_t k = 0; k < header.edges; k++) {
+        if (edges[k].dest >= n) {
+            return false;
+        }
+    }
+    // addVertex() refuses a repeated ID, which would leave the graph half filled, so repeats are rejected first
+    unordered_set<int32_t> ids;
+    ids.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        if (!ids.insert(vertices[i].id).second) {
+            return false;
+        }
+    }
+
+    // The graph is empty and every ID is new, so each vertex gets the index of its entry in the table
+    for (size_t i = 0; i < n; i++) {
+        const SnapshotVertex &v = vertices[i];
+        if (v.nameLength > 0) {
+            graph.addVertex(v.id, string(names + v.nameOffset, v.nameLength));
+        } else if (header.flags & HAS_COORDINATES) {
+            graph.addVertex(v.id, v.longitude, v.latitude);
+        } else {
+            graph.addVertex(v.id);
+        }
+    }
+
+    vector<uint32_t> offsets(n + 1);
+    vector<int> targets(header.edges);
+    vector<double> weights(header.edges);
+    for (size_t i = 0; i < n; i++) {
+        offsets[i] = (uint32_t) vertices[i].firstEdge;
+    }
+    offsets[n] = (uint32_t) header.edges;
+    for (size_t k = 0; k < header.edges; k++) {
+        targets[k] = (int) edges[k].dest;
+        weights[k] = edges[k].weight;
+    }
+    CompactGraph adjacency;
+    adjacency.assign(std::move(offsets), std::move(targets), std::move(weights));
+    graph.setAdjacency(std::move(adjacency));
+    return true;
+}
@@ -0,0 +1,87 @@
+//
+// Created by oem on 02/06/23.
+//
+
+#ifndef DA___2ND_PROJECT_SNAPSHOT_H
+#define DA___2ND_PROJECT_SNAPSHOT_H
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+#include "Graph.h"
+
+namespace fs = std::filesystem;
+using namespace std;
+
+/**
+ * @brief The Snapshot class reads and writes a binary image of a loaded graph.
+ *
+ * A snapshot holds the vertex table (id, longitude, latitude, name) and the compact adjacency of every vertex in its
+ * original order; distance matrices are persisted by MatrixCache instead. Its header carries a format version, a
+ * checksum of the payload and a fingerprint of the CSV files it was built from, so corrupt or stale snapshots are
+ * rejected and rebuilt.
+ */
+
+class Snapshot {
+public:
+
+/**
+ * The current version of the snapshot format. Files with any other version are rejected.
+ */
+
+    static constexpr uint32_t VERSION = 6;
+
+/**
+ * Gets the snapshot file used for a dataset.
+ *
+ * @param edges_file The path to the edges CSV file of the dataset.
+ * @return The path to the snapshot, next to the edges file.
+ */
+
+    static fs::path pathFor(const fs::path& edges_file);
+
+/**
+ * Fingerprints the CSV files of a dataset by their names, sizes and modification times.
+ *
+ * @param sources The paths to the CSV files; empty paths are ignored.
+ * @return The fingerprint, which changes whenever any of the files changes.
+ */
+
+    static uint64_t fingerprint(const vector<fs::path>& sources);
+
+/**
+ * Hashes a block of memory.
+ *
+ * @param data The first byte of the block.
+ * @param size The size of the block in bytes.
+ * @param seed The starting value, so several blocks can be chained.
+ * @return The 64-bit hash of the block.
+ */
+
+    static uint64_t hash(const void *data, size_t size, uint64_t seed = 0);
+
+/**
+ * Writes a snapshot of a graph. The file is written under a temporary name and renamed into place.
+ *
+ * @param graph The loaded graph.
+ * @param file_name The path to the snapshot file.
+ * @param fingerprint The fingerprint of the CSV files the graph was loaded from.
+ * @return True if the snapshot was written, false otherwise.
+ */
+
+    static bool write(const Graph& graph, const fs::path& file_name, uint64_t fingerprint);
+
+/**
+ * Loads a graph from a snapshot through a read-only memory mapping.
+ *
+ * @param graph An empty graph to fill; it is left untouched if the snapshot is rejected.
+ * @param file_name The path to the snapshot file.
+ * @param fingerprint The fingerprint of the current CSV files.
+ * @return True if the snapshot exists, is intact and matches the fingerprint, false otherwise.
+ */
+
+    static bool read(Graph& graph, const fs::path& file_name, uint64_t fingerprint);
+};
+
+
+#endif //DA___2ND_PROJECT_SNAPSHOT_H
@@ -0,0 +1,274 @@
+//
+// Created by oem on 11/06/23.
+//
+
+#include "SpatialIndex.h"
+#include "DistanceOracle.h"
+#include <cmath>
+#include <limits>
+
+/**
+ * @brief Builds the index over every vertex of a graph loaded with coordinates.
+ *
+ * @param graph The graph.
+ * @complexity O(n log n).
+ */
+
+SpatialIndex::SpatialIndex(const Graph &graph) :
+    n(graph.getNumVertex()),
+    order(n),
+    position(n),
+    point(3 * (size_t) n),
+    axis(n, 0),
+    alive(n, 0),
+    present(n, 1)
+    {
+    vector<double> byVertex(3 * (size_t) n);
+    for (int v = 0; v < n; v++) {
+        order[v] = v;
+        DistanceOracle::toUnitSphere(graph.vertexAt(v)->getLatitude(), graph.vertexAt(v)->getLongitude(),
+                                     &byVertex[3 * (size_t) v]);
+    }
+    // Sort with the vertex coordinates, then lay the points out in tree order for locality
+    point.swap(byVertex);
+    build(0, n);
+    for (int pos = 0; pos < n; pos++) {
+        position[order[pos]] = pos;
+        for (int c = 0; c < 3; c++) {
+            byVertex[3 * (size_t) pos + c] = point[3 * (size_t) order[pos] + c];
+        }
+    }
+    point.swap(byVertex);
+}
+
+/**
+ * @brief Builds the subtree of a range of positions.
+ *
+ * While building, point is still indexed by vertex.
+ *
+ * @param lo The first position of the range.
+ * @param hi One past the last position of the range.
+ */
+
+void SpatialIndex::build(int lo, int hi) {
+    if (lo >= hi) {
+        return;
+    }
+    double low[3] = {2, 2, 2};
+    double high[3] = {-2, -2, -2};
+    for (int pos = lo; pos < hi; pos++) {
+        for (int c = 0; c < 3; c++) {
+            low[c] = min(low[c], point[3 * (size_t) order[pos] + c]);
+            high[c] = max(high[c], point[3 * (size_t) order[pos] + c]);
+        }
+    }
+    int a = 0;
+    for (int c = 1; c < 3; c++) {
+        if (high[c] - low[c] > high[a] - low[a]) {
+            a = c;
+        }
+    }
+    int mid = lo + (hi - lo) / 2;
+    nth_element(order.begin() + lo, order.begin() + mid, order.begin() + hi, [&](int u, int v) {
+        return point[3 * (size_t) u + a] < point[3 * (size_t) v + a];
+    });
+    axis[mid] = (uint8_t) a;
+    alive[mid] = hi - lo;
+    build(lo, mid);
+    build(mid + 1, hi);
+}
+
+/**
+ * @brief Adds a value to the live counts of every node from the root to a position.
+ *
+ * @param pos The position.
+ * @param delta The value to add.
+ */
+
+void SpatialIndex::update(int pos, int delta) {
+    int lo = 0;
+    int hi = n;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        alive[mid] += delta;
+        if (pos == mid) {
+            return;
+        }
+        if (pos < mid) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+}
+
+/**
+ * @brief Removes a vertex from the results of every query.
+ *
+ * @param v The dense index of the vertex.
+ * @return True if the vertex was removed, false if it already was.
+ */
+
+bool SpatialIndex::remove(int v) {
+    int pos = position[v];
+    if (!present[pos]) {
+        return false;
+    }
+    present[pos] = 0;
+    update(pos, -1);
+    return true;
+}
+
+/**
+ * @brief Puts a removed vertex back into the results of the queries.
+ *
+ * @param v The dense index of the vertex.
+ * @return True if the vertex was restored, false if it was not removed.
+ */
+
+bool SpatialIndex::restore(int v) {
+    int pos = position[v];
+    if (present[pos]) {
+        return false;
+    }
+    present[pos] = 1;
+    update(pos, 1);
+    return true;
+}
+
+/**
+ * @brief Returns the squared straight-line distance between two positions.
+ *
+ * @param a The first position.
+ * @param b The second position.
+ * @return The squared chord between the two points.
+ */
+
+double SpatialIndex::distance2(int a, int b) const {
+    const double *p = &point[3 * (size_t) a];
+    const double *q = &point[3 * (size_t) b];
+    double dx = p[0] - q[0];
+    double dy = p[1] - q[1];
+    double dz = p[2] - q[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+/**
+ * @brief Collects the k nearest live positions around a position within a subtree.
+ *
+ * Candidates are ordered by distance, then by vertex, so equally near vertices are returned smallest first. The
+ * side of the split holding the query is searched first, and the other side only if the splitting plane is not
+ * farther than the worst candidate kept.
+ *
+ * @param lo The first position of the subtree.
+ * @param hi One past the last position of the subtree.
+ * @param query The position searched around.
+ * @param k The number of positions wanted.
+ * @param radius2 Positions farther than this squared chord are ignored.
+ * @param heap The best candidates so far, a max-heap of (squared chord, vertex).
+ */
+
+void SpatialIndex::search(int lo, int hi, int query, size_t k, double radius2, vector<pair<double, int>> &heap) const {
+    if (lo >= hi) {
+        return;
+    }
+    int mid = lo + (hi - lo) / 2;
+    if (alive[mid] == 0) {
+        return;
+    }
+    if (present[mid] && mid != query) {
+        pair<double, int> candidate(distance2(mid, query), order[mid]);
+        if (candidate.first <= radius2 && (heap.size() < k || candidate < heap.front())) {
+            heap.push_back(candidate);
+            push_heap(heap.begin(), heap.end());
+            if (heap.size() > k) {
+                pop_heap(heap.begin(), heap.end());
+                heap.pop_back();
+            }
+        }
+    }
+    int a = axis[mid];
+    double diff = point[3 * (size_t) query + a] - point[3 * (size_t) mid + a];
+    bool left = diff < 0;
+    if (left) {
+        search(lo, mid, query, k, radius2, heap);
+    } else {
+        search(mid + 1, hi, query, k, radius2, heap);
+    }
+    double bound = heap.size() < k ? radius2 : heap.front().first;
+    if (diff * diff <= bound) {
+        if (left) {
+            search(mid + 1, hi, query, k, radius2, heap);
+        } else {
+            search(lo, mid, query, k, radius2, heap);
+        }
+    }
+}
+
+/**
+ * @brief Finds the nearest vertex that was not removed.
+ *
+ * @param v The dense index of the vertex to search around; it is never its own result.
+ * @return The dense index of the nearest vertex, the smallest one among equally near vertices, or -1 if there is
+ * none left.
+ */
+
+int SpatialIndex::nearest(int v) const {
+    vector<int> result = nearest(v, 1);
+    return result.empty() ? -1 : result[0];
+}
+
+/**
+ * @brief Finds the k nearest vertices that were not removed.
+ *
+ * @param v The dense index of the vertex to search around; it is never part of the result.
+ * @param k The number of vertices wanted.
+ * @return Up to k dense indices, nearest first.
+ */
+
+vector<int> SpatialIndex::nearest(int v, int k) const {
+    vector<pair<double, int>> heap;
+    if (k > 0) {
+        heap.reserve(k + 1);
+        search(0, n, position[v], k, numeric_limits<double>::max(), heap);
+    }
+    sort_heap(heap.begin(), heap.end());
+    vector<int> result;
+    for (const auto &candidate : heap) {
+        result.push_back(candidate.second);
+    }
+    return result;
+}
+
+/**
+ * @brief Finds every vertex within a distance that was not removed.
+ *
+ * A great-circle distance d is a chord of 2 sin(d / 2R) on the unit sphere.
+ *
+ * @param v The dense index of the vertex to search around; it is never part of the result.
+ * @param meters The search radius, as a great-circle distance.
+ * @return The dense indices of the vertices in the radius, nearest first.
+ */
+
+vector<int> SpatialIndex::within(int v, double meters) const {
+    double angle = min(M_PI, max(0.0, meters / DistanceOracle::EARTH_RADIUS));
+    double chord = 2 * sin(angle / 2);
+    vector<pair<double, int>> heap;
+    search(0, n, position[v], SIZE_MAX, chord * chord, heap);
+    sort_heap(heap.begin(), heap.end());
+    vector<int> result;
+    for (const auto &candidate : heap) {
+        result.push_back(candidate.second);
+    }
+    return result;
+}
+
+/**
+ * @brief Returns the number of vertices not removed.
+ *
+ * @return The number of vertices the queries can return.
+ */
+
+int SpatialIndex::size() const {
+    return n == 0 ? 0 : alive[n / 2];
+}
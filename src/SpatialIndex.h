@@ -0,0 +1,146 @@
+//
+// Created by oem on 11/06/23.
+//
+
+#ifndef DA___2ND_PROJECT_SPATIALINDEX_H
+#define DA___2ND_PROJECT_SPATIALINDEX_H
+
+#include <cstdint>
+#include <vector>
+#include "Graph.h"
+
+using namespace std;
+
+/**
+ * @brief The SpatialIndex class is a k-d tree over the coordinates of the vertices of a graph.
+ *
+ * Vertices are placed on the unit sphere, where the straight-line distance orders pairs exactly as the haversine
+ * distance does, and split along the widest axis at every level. The tree is stored implicitly: the node of a range
+ * of positions is its middle position, so it takes a few arrays of n entries and no pointers.
+ *
+ * Vertices can be removed and restored in O(log n). Every node counts the vertices left in its subtree, so queries
+ * skip emptied subtrees; that makes repeated nearest-unvisited queries, as in nearest neighbour tours, cost about
+ * O(log n) each instead of a scan of every vertex.
+ */
+
+class SpatialIndex {
+public:
+
+/**
+ * @brief Builds the index over every vertex of a graph loaded with coordinates.
+ *
+ * @param graph The graph.
+ * @complexity O(n log n).
+ */
+
+    explicit SpatialIndex(const Graph &graph);
+
+/**
+ * @brief Removes a vertex from the results of every query.
+ *
+ * @param v The dense index of the vertex.
+ * @return True if the vertex was removed, false if it already was.
+ */
+
+    bool remove(int v);
+
+/**
+ * @brief Puts a removed vertex back into the results of the queries.
+ *
+ * @param v The dense index of the vertex.
+ * @return True if the vertex was restored, false if it was not removed.
+ */
+
+    bool restore(int v);
+
+/**
+ * @brief Finds the nearest vertex that was not removed.
+ *
+ * @param v The dense index of the vertex to search around; it is never its own result.
+ * @return The dense index of the nearest vertex, the smallest one among equally near vertices, or -1 if there is
+ * none left.
+ */
+
+    int nearest(int v) const;
+
+/**
+ * @brief Finds the k nearest vertices that were not removed.
+ *
+ * @param v The dense index of the vertex to search around; it is never part of the result.
+ * @param k The number of vertices wanted.
+ * @return Up to k dense indices, nearest first.
+ */
+
+    vector<int> nearest(int v, int k) const;
+
+/**
+ * @brief Finds every vertex within a distance that was not removed.
+ *
+ * @param v The dense index of the vertex to search around; it is never part of the result.
+ * @param meters The search radius, as a great-circle distance.
+ * @return The dense indices of the vertices in the radius, nearest first.
+ */
+
+    vector<int> within(int v, double meters) const;
+
+/**
+ * @brief Returns the number of vertices not removed.
+ *
+ * @return The number of vertices the queries can return.
+ */
+
+    int size() const;
+
+private:
+    int n; /**< Number of vertices */
+    vector<int> order; /**< The vertex at each position of the tree */
+    vector<int> position; /**< The position of each vertex */
+    vector<double> point; /**< The unit-sphere point at each position, 3 coordinates per position */
+    vector<uint8_t> axis; /**< The split axis of the node at each position */
+    vector<int> alive; /**< The number of vertices left in the subtree of the node at each position */
+    vector<uint8_t> present; /**< Whether each vertex, by position, was not removed */
+
+/**
+ * @brief Builds the subtree of a range of positions.
+ *
+ * @param lo The first position of the range.
+ * @param hi One past the last position of the range.
+ */
+
+    void build(int lo, int hi);
+
+/**
+ * @brief Adds a value to the live counts of every node from the root to a position.
+ *
+ * @param pos The position.
+ * @param delta The value to add.
+ */
+
+    void update(int pos, int delta);
+
+/**
+ * @brief Returns the squared straight-line distance between two positions.
+ *
+ * @param a The first position.
+ * @param b The second position.
+ * @return The squared chord between the two points.
+ */
+
+    double distance2(int a, int b) const;
+
+/**
+ * @brief Collects the k nearest live positions around a position within a subtree.
+ *
+ * @param lo The first position of the subtree.
+ * @param hi One past the last position of the subtree.
+ * @param query The position searched around.
+ * @param k The number of positions wanted.
+ * @param radius2 Positions farther than this squared chord are ignored.
+ * @param heap The best candidates so far, a max-heap of (squared chord, vertex).
+ */
+
+    void search(int lo, int hi, int query, size_t k, double radius2, vector<pair<double, int>> &heap) const;
+};
+
+
+#endif //DA___2ND_PROJECT_SPATIALINDEX_H
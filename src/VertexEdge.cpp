@@ -35,6 +35,19 @@ Vertex::Vertex(int id, double longitude, double latitude) :
 
 Vertex::Vertex(int id, string name): id(id), name(name) {}
 
+/**
+ * @brief Destructor for the Vertex class.
+ *
+ * Deletes the outgoing edges, which the vertex owns. The incoming lists of their destinations are left untouched,
+ * so vertices are meant to be destroyed together, as Graph does.
+ */
+
+Vertex::~Vertex() {
+    for (Edge *edge : adj) {
+        delete edge;
+    }
+}
+
 /**
  * @brief Adds an outgoing edge to the vertex with the given destination vertex and weight.
  *
@@ -75,17 +88,6 @@ bool Vertex::removeEdge(int destID) {
     return removedEdge;
 }
 
-/**
- * @brief Overloaded less than operator for comparing vertices based on distance (dist).
- *
- * @param vertex The vertex to compare with.
- * @return True if this vertex's distance is less than the other vertex's distance, false otherwise.
- */
-
-bool Vertex::operator<(Vertex & vertex) const {
-    return this->dist < vertex.dist;
-}
-
 /**
  * @brief Gets the ID of the vertex.
  *
@@ -97,113 +99,83 @@ int Vertex::getId() const {
 }
 
 /**
- * @brief Gets the adjacent edges of the vertex.
+ * @brief Gets the position of the vertex in the graph's adjacency.
  *
- * @return A vector of pointers to the adjacent edges.
+ * @return The dense index of the vertex, or -1 if it does not belong to a graph.
  */
 
-std::vector<Edge*> Vertex::getAdj() const {
-    return this->adj;
+int Vertex::getIndex() const {
+    return this->index;
 }
 
 /**
- * @brief Checks if the vertex is visited.
+ * @brief Sets the position of the vertex in the graph's adjacency.
  *
- * @return True if the vertex is visited, false otherwise.
+ * @param index The dense index of the vertex.
  */
 
-bool Vertex::isVisited() const {
-    return this->visited;
+void Vertex::setIndex(int index) {
+    this->index = index;
 }
 
 /**
- * @brief Gets the distance of the vertex.
+ * @brief Gets the longitude of the vertex.
  *
- * @return The distance of the vertex.
+ * @return The longitude coordinate of the vertex, 0 if it was loaded without coordinates.
  */
 
-double Vertex::getDist() const {
-    return this->dist;
+double Vertex::getLongitude() const {
+    return this->longitude;
 }
 
 /**
- * @brief Gets the path to the vertex.
+ * @brief Gets the latitude of the vertex.
  *
- * @return A pointer to the path edge.
+ * @return The latitude coordinate of the vertex, 0 if it was loaded without coordinates.
  */
 
-Edge *Vertex::getPath() const {
-    return this->path;
+double Vertex::getLatitude() const {
+    return this->latitude;
 }
 
 /**
- * @brief Gets the incoming edges of the vertex.
+ * @brief Gets the name of the vertex.
  *
- * @return A vector of pointers to the incoming edges.
+ * @return The name of the vertex, empty if it was loaded without one.
  */
 
-std::vector<Edge *> Vertex::getIncoming() const {
-    return this->incoming;
+const string &Vertex::getName() const {
+    return this->name;
 }
 
 /**
- * @brief Sets the ID of the vertex.
- *
- * @param id The ID of the vertex.
- */
-
-void Vertex::setId(int id) {
-    this->id = id;
-}
-
-/**
- * @brief Sets the visited status of the vertex.
- *
- * @param visited The visited status of the vertex.
- */
-
-void Vertex::setVisited(bool visited) {
-    this->visited = visited;
-}
-
-/**
- * @brief Sets the processing status of the vertex.
- *
- * @param processing The processing status of the vertex.
- */
-
-void Vertex::setProcesssing(bool processing) {
-    this->processing = processing;
-}
-
-/**
- * @brief Sets the distance of the vertex.
+ * @brief Gets the adjacent edges of the vertex.
  *
- * @param dist The distance of the vertex.
+ * @return A reference to the vector of adjacent edges, valid while the vertex lives.
  */
 
-void Vertex::setIndegree(unsigned int indegree) {
-    this->indegree = indegree;
+const std::vector<Edge *> &Vertex::getAdj() const {
+    return this->adj;
 }
 
 /**
- * @brief Sets the distance of the vertex.
+ * @brief Gets the incoming edges of the vertex.
  *
- * @param dist The distance of the vertex.
+ * @return A reference to the vector of incoming edges, valid while the vertex lives.
  */
 
-void Vertex::setDist(double dist) {
-    this->dist = dist;
+const std::vector<Edge *> &Vertex::getIncoming() const {
+    return this->incoming;
 }
 
 /**
- * @brief Sets the path to the vertex.
+ * @brief Sets the ID of the vertex.
  *
- * @param path A pointer to the path edge.
+ * @param id The ID of the vertex.
  */
 
-void Vertex::setPath(Edge *path) {
-    this->path = path;
+void Vertex::setId(int id) {
+    this->id = id;
 }
 
 /**
@@ -12,7 +12,6 @@
 #include <limits>
 #include <algorithm>
 #include <unordered_map>
-#include "MutablePriorityQueue.h"
 
 using namespace std;
 
@@ -28,6 +27,8 @@ class Edge;
 
 /**
  * @brief The Vertex class is used to represent the vertices of the graph.
+ *
+ * A vertex only holds what is read from the dataset; the algorithms keep their per-run state in a Workspace.
  */
 
 class Vertex {
@@ -61,13 +62,13 @@ public:
     Vertex(int id, string name);
 
 /**
- * @brief Overloaded less than operator for comparing vertices based on distance (dist).
+ * @brief Destructor for the Vertex class.
  *
- * @param vertex The vertex to compare with.
- * @return True if this vertex's distance is less than the other vertex's distance, false otherwise.
+ * Deletes the outgoing edges, which the vertex owns. The incoming lists of their destinations are left untouched,
+ * so vertices are meant to be destroyed together, as Graph does.
  */
 
-    bool operator<(Vertex & vertex) const; // // required by MutablePriorityQueue
+    ~Vertex();
 
 /**
  * @brief Gets the ID of the vertex.
@@ -78,92 +79,68 @@ public:
     int getId() const;
 
 /**
- * @brief Gets the adjacent edges of the vertex.
- *
- * @return A vector of pointers to the adjacent edges.
- */
-
-    std::vector<Edge *> getAdj() const;
-
-/**
- * @brief Checks if the vertex is visited.
- *
- * @return True if the vertex is visited, false otherwise.
- */
-
-    bool isVisited() const;
-
-/**
- * @brief Gets the distance of the vertex.
- *
- * @return The distance of the vertex.
- */
-
-    double getDist() const;
-
-/**
- * @brief Gets the path to the vertex.
+ * @brief Gets the position of the vertex in the graph's adjacency.
  *
- * @return A pointer to the path edge.
+ * @return The dense index of the vertex, or -1 if it does not belong to a graph.
  */
 
-    Edge *getPath() const;
+    int getIndex() const;
 
 /**
- * @brief Gets the incoming edges of the vertex.
+ * @brief Sets the position of the vertex in the graph's adjacency.
  *
- * @return A vector of pointers to the incoming edges.
+ * @param index The dense index of the vertex.
  */
 
-    std::vector<Edge *> getIncoming() const;
+    void setIndex(int index);
 
 /**
- * @brief Sets the ID of the vertex.
+ * @brief Gets the longitude of the vertex.
  *
- * @param id The ID of the vertex.
+ * @return The longitude coordinate of the vertex, 0 if it was loaded without coordinates.
  */
 
-    void setId(int info);
+    double getLongitude() const;
 
 /**
- * @brief Sets the visited status of the vertex.
+ * @brief Gets the latitude of the vertex.
  *
- * @param visited The visited status of the vertex.
+ * @return The latitude coordinate of the vertex, 0 if it was loaded without coordinates.
  */
 
-    void setVisited(bool visited);
+    double getLatitude() const;
 
 /**
- * @brief Sets the processing status of the vertex.
+ * @brief Gets the name of the vertex.
  *
- * @param processing The processing status of the vertex.
+ * @return The name of the vertex, empty if it was loaded without one.
  */
 
-    void setProcesssing(bool processing);
+    const string &getName() const;
 
 /**
- * @brief Sets the distance of the vertex.
+ * @brief Gets the adjacent edges of the vertex.
  *
- * @param dist The distance of the vertex.
+ * @return A reference to the vector of adjacent edges, valid while the vertex lives.
  */
 
-    void setIndegree(unsigned int indegree);
+    const std::vector<Edge *> &getAdj() const;
 
 /**
- * @brief Sets the distance of the vertex.
+ * @brief Gets the incoming edges of the vertex.
  *
- * @param dist The distance of the vertex.
+ * @return A reference to the vector of incoming edges, valid while the vertex lives.
  */
 
-    void setDist(double dist);
+    const std::vector<Edge *> &getIncoming() const;
 
 /**
- * @brief Sets the path to the vertex.
+ * @brief Sets the ID of the vertex.
  *
- * @param path A pointer to the path edge.
+ * @param id The ID of the vertex.
  */
 
-    void setPath(Edge *path);
+    void setId(int info);
 
 /**
  * @brief Adds an outgoing edge to the vertex with the given destination vertex and weight.
@@ -184,25 +161,18 @@ public:
 
     bool removeEdge(int destID);
 
-    friend class MutablePriorityQueue<Vertex>;
 protected:
     int id;                // vertex ID
-    double longitude;
-    double latitude;
+    int index = -1;        // position in the graph's adjacency
+    double longitude = 0;
+    double latitude = 0;
     string name;
     std::vector<Edge *> adj;  // outgoing edges
 
-    // auxiliary fields
-    bool visited = false; // used by DFS, BFS, Prim ...
-    bool processing = false; // used by isDAG (in addition to the visited attribute)
-    unsigned int indegree; // used by topsort
-    double dist = 0; // distance (used in algorithms)
-    Edge *path = nullptr;
+    // the state of a run (visited, dist, path, queueIndex) lives in a Workspace, so the vertex is shared read-only
 
     vector<Edge *> incoming; // incoming edges
 
-    int queueIndex = 0; 		// required by MutablePriorityQueue and UFDS
-
 /**
  * @brief Deletes an edge and updates the incoming edges of the destination vertex.
  *
@@ -0,0 +1,123 @@
+//
+// Created by oem on 10/06/23.
+//
+
+#include "Workspace.h"
+
+/**
+ * @brief Sizes the workspace for a graph and clears it.
+ *
+ * @param n The number of vertices.
+ */
+
+void Workspace::reset(int n) {
+    visited.assign(n, 0);
+    dist.assign(n, 0.0);
+    path.assign(n, SIZE_MAX);
+    queueIndex.assign(n, 0);
+}
+
+/**
+ * @brief Constructs an empty queue over the state of a workspace.
+ *
+ * @param work The workspace holding the keys and heap positions; it must outlive the queue.
+ */
+
+IndexPriorityQueue::IndexPriorityQueue(Workspace &work) : H(1, -1), key(work.dist), position(work.queueIndex) {
+    // positions start at 1 to facilitate parent/child calculations
+}
+
+/**
+ * @brief Checks if the queue is empty.
+ *
+ * @return True if the queue is empty, false otherwise.
+ */
+
+bool IndexPriorityQueue::empty() const {
+    return H.size() == 1;
+}
+
+/**
+ * @brief Extracts the index with the smallest key.
+ *
+ * @return The index.
+ */
+
+int IndexPriorityQueue::extractMin() {
+    int x = H[1];
+    H[1] = H.back();
+    H.pop_back();
+    if (H.size() > 1) heapifyDown(1);
+    position[x] = 0;
+    return x;
+}
+
+/**
+ * @brief Inserts an index into the queue.
+ *
+ * @param x The index to insert.
+ */
+
+void IndexPriorityQueue::insert(int x) {
+    H.push_back(x);
+    heapifyUp(H.size() - 1);
+}
+
+/**
+ * @brief Moves an index up after its key was decreased.
+ *
+ * @param x The index whose key was decreased.
+ */
+
+void IndexPriorityQueue::decreaseKey(int x) {
+    heapifyUp(position[x]);
+}
+
+/**
+ * @brief Restores the heap property by moving an element up the heap.
+ *
+ * @param i The position of the element to heapify up.
+ */
+
+void IndexPriorityQueue::heapifyUp(unsigned i) {
+    int x = H[i];
+    while (i > 1 && key[x] < key[H[i / 2]]) {
+        set(i, H[i / 2]);
+        i = i / 2;
+    }
+    set(i, x);
+}
+
+/**
+ * @brief Restores the heap property by moving an element down the heap.
+ *
+ * @param i The position of the element to heapify down.
+ */
+
+void IndexPriorityQueue::heapifyDown(unsigned i) {
+    int x = H[i];
+    while (true) {
+        unsigned k = i * 2;
+        if (k >= H.size())
+            break;
+        if (k + 1 < H.size() && key[H[k + 1]] < key[H[k]])
+            ++k; // right child of i
+        if (!(key[H[k]] < key[x]))
+            break;
+        set(i, H[k]);
+        i = k;
+    }
+    set(i, x);
+}
+
+/**
+ * @brief Sets an element at a given position in the heap.
+ *
+ * @param i The position to set the element.
+ * @param x The index to set.
+ */
+
+void IndexPriorityQueue::set(unsigned i, int x) {
+    H[i] = x;
+    position[x] = i;
+}
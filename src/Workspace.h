@@ -0,0 +1,119 @@
+//
+// Created by oem on 10/06/23.
+//
+
+#ifndef DA___2ND_PROJECT_WORKSPACE_H
+#define DA___2ND_PROJECT_WORKSPACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief The Workspace struct holds the per-vertex state of one run of an algorithm, by dense index.
+ *
+ * The graph itself is never written by the algorithms, so any number of runs, each with its own workspace, can share
+ * one loaded graph at the same time.
+ */
+
+struct Workspace {
+    vector<uint8_t> visited; /**< Whether each vertex is already in the tree of Services::primSparse() */
+    vector<double> dist; /**< The distance or key of each vertex */
+    vector<size_t> path; /**< The adjacency position of the edge each vertex was reached by, SIZE_MAX if none */
+    vector<unsigned> queueIndex; /**< The heap position of each vertex, required by IndexPriorityQueue */
+
+/**
+ * @brief Sizes the workspace for a graph and clears it.
+ *
+ * @param n The number of vertices.
+ */
+
+    void reset(int n);
+};
+
+/**
+ * @brief The IndexPriorityQueue class is a mutable min-priority queue of dense indices.
+ *
+ * It is a binary heap of the vertices of a Workspace: the keys are read from Workspace::dist and the heap position of
+ * each vertex is kept in Workspace::queueIndex, so a decreased key moves up in O(log n) without a search. It is the
+ * queue of Services::primSparse(), which builds the spanning trees of TAH and the 1-trees of the lower bound on
+ * graphs without a complete distance matrix.
+ */
+
+class IndexPriorityQueue {
+    vector<int> H; /**< The heap storing the indices, from position 1 */
+    const vector<double> &key; /**< The key of each index */
+    vector<unsigned> &position; /**< The heap position of each index */
+
+/**
+ * @brief Restores the heap property by moving an element up the heap.
+ *
+ * @param i The position of the element to heapify up.
+ */
+
+    void heapifyUp(unsigned i);
+
+/**
+ * @brief Restores the heap property by moving an element down the heap.
+ *
+ * @param i The position of the element to heapify down.
+ */
+
+    void heapifyDown(unsigned i);
+
+/**
+ * @brief Sets an element at a given position in the heap.
+ *
+ * @param i The position to set the element.
+ * @param x The index to set.
+ */
+
+    void set(unsigned i, int x);
+
+public:
+
+/**
+ * @brief Constructs an empty queue over the state of a workspace.
+ *
+ * @param work The workspace holding the keys and heap positions; it must outlive the queue.
+ */
+
+    explicit IndexPriorityQueue(Workspace &work);
+
+/**
+ * @brief Inserts an index into the queue.
+ *
+ * @param x The index to insert.
+ */
+
+    void insert(int x);
+
+/**
+ * @brief Extracts the index with the smallest key.
+ *
+ * @return The index.
+ */
+
+    int extractMin();
+
+/**
+ * @brief Moves an index up after its key was decreased.
+ *
+ * @param x The index whose key was decreased.
+ */
+
+    void decreaseKey(int x);
+
+/**
+ * @brief Checks if the queue is empty.
+ *
+ * @return True if the queue is empty, false otherwise.
+ */
+
+    bool empty() const;
+};
+
+
+#endif //DA___2ND_PROJECT_WORKSPACE_H